@@ -0,0 +1,112 @@
+#pragma once
+#include "DataSource.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+/**
+ * Structs of the Apache Arrow C Data Interface (https://arrow.apache.org/docs/format/CDataInterface.html).
+ * The definitions are part of the stable C ABI and are copied from the specification, so no Arrow library
+ * is needed. The guard is the one recommended by the specification, so that the definitions do not clash
+ * with the ones of an Arrow library that is included as well.
+ */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C"
+{
+    struct ArrowSchema
+    {
+        // Array type description
+        const char *format;
+        const char *name;
+        const char *metadata;
+        int64_t flags;
+        int64_t n_children;
+        struct ArrowSchema **children;
+        struct ArrowSchema *dictionary;
+
+        // Release callback
+        void (*release)(struct ArrowSchema *);
+        // Opaque producer-specific data
+        void *private_data;
+    };
+
+    struct ArrowArray
+    {
+        // Array data description
+        int64_t length;
+        int64_t null_count;
+        int64_t offset;
+        int64_t n_buffers;
+        int64_t n_children;
+        const void **buffers;
+        struct ArrowArray **children;
+        struct ArrowArray *dictionary;
+
+        // Release callback
+        void (*release)(struct ArrowArray *);
+        // Opaque producer-specific data
+        void *private_data;
+    };
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+/**
+ * DataSource view of an Arrow record batch, exported through the Arrow C Data Interface, without copying it.
+ * The record batch is a struct array (format "+s"), each child is one column of the sample (e.g., the
+ * label first for LinearRegressionLearner). Columns must be float64 ("g") or float32 ("f") without nulls.
+ * float32 columns are converted to double when rows are gathered.
+ *
+ * The data source only borrows the buffers: the producer keeps the ownership of schema and array, and must
+ * not release them before the data source is destroyed.
+ */
+class ArrowDataSource : public DataSource
+{
+public:
+    enum class ColumnType
+    {
+        Float64,
+        Float32
+    };
+
+private:
+    // One column of the record batch. data points to the first row (the offsets are already applied).
+    struct Column
+    {
+        std::string name;
+        ColumnType type;
+        const void *data;
+    };
+
+    std::vector<Column> _columns;
+    Eigen::Index _rows = 0;
+
+    const Column &_column(Eigen::Index j, ColumnType expectedType) const;
+
+protected:
+    // Advises the buffer of each column, which the producer may have mapped from a file (e.g., an Arrow IPC file)
+    void _adviseAccessOnce(bool randomRows) const override;
+
+public:
+    ArrowDataSource(const ArrowSchema *schema, const ArrowArray *array);
+
+    Eigen::Index rows() const override;
+    Eigen::Index cols() const override;
+    void gatherRows(const int *indices, Eigen::Index count, Sample &out) const override;
+    void copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const override;
+
+    const std::string &columnName(Eigen::Index j) const;
+    ColumnType columnType(Eigen::Index j) const;
+
+    // The j-th column as an Eigen map on the producer's buffer. The type of the column must match.
+    Eigen::Map<const Eigen::VectorXd> float64Column(Eigen::Index j) const;
+    Eigen::Map<const Eigen::VectorXf> float32Column(Eigen::Index j) const;
+};
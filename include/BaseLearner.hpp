@@ -1,5 +1,9 @@
 #pragma once
 #include "types.hpp"
+#include "CancellationToken.hpp"
+
+#include <memory>    // For std::unique_ptr
+#include <stdexcept> // For std::invalid_argument, std::logic_error
 
 // We make functions pure virtual to be implemented in derived classes
 struct BaseLearner
@@ -12,6 +16,19 @@ struct BaseLearner
      */
     virtual Result learn(const Sample &sample) = 0;
 
+    /**
+     * Learning with cooperative cancellation, called instead of learn when a learn deadline is set
+     * (see _BaseVE::setLearnDeadline). Iterative learners should override it to poll cancellation between
+     * iterations and throw OperationCancelled once it is cancelled (e.g., by cancellation.throwIfCancelled),
+     * so that a subsample that exceeds the deadline is abandoned and replaced. The default ignores
+     * cancellation and calls learn, so its subsamples always run to completion and are kept.
+     */
+    virtual Result learnCancellable(const Sample &sample, const CancellationToken &cancellation)
+    {
+        (void)cancellation;
+        return learn(sample);
+    }
+
     /**
      * Evaluate a single solution on (possibly multiple) samples
      * Returns a vector of size num_samples
@@ -19,10 +36,100 @@ struct BaseLearner
     virtual Vector objective(const Result &learningResult, const Sample &sample) const = 0;
     virtual bool isMinimization() const = 0;
 
+    /**
+     * Whether the objective is linear in the sample row, i.e., objective(learningResult, sample) equals
+     * sample * learningResult. Then the mean objective on a subsample is the subsample mean row times the
+     * solution, and _CachedEvaluator evaluates all candidates on all subsamples with one matrix product
+     * instead of evaluating objective on every row.
+     */
+    virtual bool isLinearObjective() const
+    {
+        return false;
+    }
+
     // Deduplication check (Must be enabled for discrete problems, i.e., MoVE)
     virtual bool enableDeduplication() const = 0;
     virtual bool isDuplicate(const Result &result1, const Result &result2) const = 0;
 
+    /**
+     * Batched deduplication check: return the index of the first column of uniqueSet that is a duplicate of
+     * result (by isDuplicate), or -1 if there is none. Each column of uniqueSet is a candidate of the same size
+     * as result, otherwise std::invalid_argument is thrown. The default calls isDuplicate for each column;
+     * learners whose isDuplicate is an L1-distance below a tolerance should override it with
+     * findDuplicateByL1Distance, a single pass over uniqueSet.
+     */
+    virtual Eigen::Index findDuplicate(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet) const
+    {
+        checkDuplicateCandidates(result, uniqueSet);
+        Result column;
+        for (Eigen::Index j = 0; j < uniqueSet.cols(); ++j)
+        {
+            column = uniqueSet.col(j);
+            if (isDuplicate(result, column))
+                return j;
+        }
+        return -1;
+    }
+
+    // findDuplicate for the duplicates within L1-distance tolerance, with the L1-distances to all columns in one pass
+    static Eigen::Index findDuplicateByL1Distance(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet,
+                                                  double tolerance)
+    {
+        checkDuplicateCandidates(result, uniqueSet);
+        if (uniqueSet.cols() == 0)
+            return -1;
+
+        RowVector distances = (uniqueSet.colwise() - result).cwiseAbs().colwise().sum();
+        for (Eigen::Index j = 0; j < distances.size(); ++j)
+        {
+            if (distances(j) < tolerance)
+                return j;
+        }
+        return -1;
+    }
+
+    // Error policy of findDuplicate: the candidates must have the size of result
+    static void checkDuplicateCandidates(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet)
+    {
+        if (uniqueSet.cols() > 0 && result.size() != uniqueSet.rows())
+            throw std::invalid_argument("BaseLearner::findDuplicate: Results must have the same size");
+    }
+
+    /**
+     * State of an incremental learner, e.g., sufficient statistics of the rows added so far.
+     * Learners that support incremental learning derive their own state from it.
+     */
+    struct IncrementalState
+    {
+        virtual ~IncrementalState() = default;
+    };
+
+    /**
+     * Incremental learning (optional), used by the subsample-size sweeps of MoVE and ROVE.
+     * When supported, a subsample that extends a smaller one is learned by adding only the new rows.
+     */
+    virtual bool supportsIncrementalLearning() const
+    {
+        return false;
+    }
+
+    // Create an empty state, to which rows are added by learnIncremental
+    virtual std::unique_ptr<IncrementalState> createIncrementalState() const
+    {
+        throw std::logic_error("BaseLearner::createIncrementalState: Incremental learning is not supported.");
+    }
+
+    /**
+     * Add newRows to state and return the result of learning on all rows added so far.
+     * The result must agree with learn on those rows (up to rounding).
+     */
+    virtual Result learnIncremental(IncrementalState &state, const Sample &newRows)
+    {
+        (void)state;
+        (void)newRows;
+        throw std::logic_error("BaseLearner::learnIncremental: Incremental learning is not supported.");
+    }
+
     // Serialization
     virtual void dumpLearningResult(const Result &learningResult, std::ostream &out) const
     {
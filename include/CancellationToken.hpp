@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>    // For std::atomic
+#include <chrono>    // For std::chrono::steady_clock (deadlines)
+#include <memory>    // For std::shared_ptr
+#include <stdexcept> // For std::runtime_error
+#include <string>
+
+/**
+ * Thrown by a run that stopped because its CancellationToken was cancelled.
+ * The future returned by runAsync then holds this exception.
+ */
+class OperationCancelled : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Shared flag to cancel a run started by MoVE::runAsync or ROVE::runAsync.
+ * Copies of a token share the flag, so the caller keeps one copy and passes another to runAsync.
+ * Cancellation is cooperative: the run checks the flag between subsamples (while learning) and between
+ * chunks of evaluation (ROVE Phase II), so a single call to BaseLearner::learn or objective is never
+ * interrupted. A run that has not started yet is dropped without any work.
+ * Tokens are also passed to BaseLearner::learnCancellable when a learn deadline is set (see
+ * _BaseVE::setLearnDeadline), so that an iterative learner can stop within a call.
+ */
+class CancellationToken
+{
+private:
+    // Shared by the copies of a token; a token made by withDeadline also checks the state of its parent
+    struct _State
+    {
+        std::atomic<bool> cancelled{false};
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        std::shared_ptr<const _State> parent;
+    };
+    std::shared_ptr<_State> _state;
+
+public:
+    // Create a token that is not cancelled
+    CancellationToken();
+
+    // Request cancellation, safe to call from any thread and more than once
+    void cancel();
+
+    // Whether cancel was called on this token (or its parent), or its deadline has passed
+    bool isCancelled() const;
+
+    /**
+     * Token that is cancelled when this one is, or once deadline has passed, e.g., to bound a single call
+     * to BaseLearner::learnCancellable. Cancelling the new token does not cancel this one.
+     */
+    CancellationToken withDeadline(std::chrono::steady_clock::time_point deadline) const;
+
+    // Throw OperationCancelled (with the name of the caller in the message) if cancellation was requested
+    void throwIfCancelled(const std::string &caller) const;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "DataSource.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * In-memory DataSource that stores each column in a compact encoding, decoded on the fly when rows are
+ * gathered (by _BaseVE for learning and by _CachedEvaluator for evaluation). Low-cardinality and low-precision
+ * columns take a fraction of the 8 bytes per value of a Sample, so larger datasets stay memory-resident and
+ * gathers read less memory.
+ *
+ * Encodings (per column):
+ *   Float64:    raw doubles (lossless).
+ *   Dictionary: distinct values in a dictionary, and bit-packed codes of ceil(log2(num distinct)) bits (lossless).
+ *   BitPacked:  integer values stored as value - min in ceil(log2(max - min + 1)) bits (lossless).
+ *   Float16:    IEEE half precision of value / scale (lossy, about 3 significant digits).
+ *   BFloat16:   bfloat16 of value / scale (lossy, about 2 significant digits, but the full exponent range).
+ * For Float16 and BFloat16, the scale maps the largest absolute value of the column to 2^15, so that no value
+ * overflows and small values keep their relative precision.
+ */
+class CompressedDataSource : public DataSource
+{
+public:
+    enum class Encoding
+    {
+        Float64,
+        Dictionary,
+        BitPacked,
+        Float16,
+        BFloat16
+    };
+
+    // Largest dictionary size considered by chooseEncodings and accepted by the Dictionary encoding.
+    static constexpr size_t MAX_DICTIONARY_SIZE = 1 << 16;
+
+private:
+    struct Column
+    {
+        Encoding encoding = Encoding::Float64;
+        int bitWidth = 0;                // Dictionary and BitPacked: bits per code
+        double base = 0.0;               // BitPacked: the minimum value
+        double scale = 1.0;              // Float16 and BFloat16: decoded value = scale * stored value
+        std::vector<double> raw;         // Float64
+        std::vector<double> dictionary;  // Dictionary
+        std::vector<std::uint64_t> bits; // Dictionary and BitPacked: packed codes (with one padding word)
+        std::vector<std::uint16_t> half; // Float16 and BFloat16
+    };
+
+    Eigen::Index _rows = 0;
+    std::vector<Column> _columns;
+
+    // Number of rows read at once from the input while encoding
+    static constexpr Eigen::Index ENCODE_BLOCK_ROWS = 4096;
+
+    // Decode the values of column j at the given rows into out
+    void _decodeColumn(Eigen::Index j, const int *rowIndices, Eigen::Index count, double *out) const;
+
+public:
+    /**
+     * Encode data (e.g., a DenseDataSource or an ArrowDataSource) with encodings[j] for column j.
+     * The input is read in blocks of rows, so it is never copied as a whole.
+     * Throws std::invalid_argument if a column cannot be represented by its encoding (e.g., a non-integer
+     * value for BitPacked, or too many distinct values for Dictionary).
+     */
+    CompressedDataSource(const DataSource &data, const std::vector<Encoding> &encodings);
+    CompressedDataSource(const Sample &sample, const std::vector<Encoding> &encodings);
+
+    /**
+     * Choose the lossless encoding of each column that takes the fewest bytes (counting the dictionary) among
+     * Float64, Dictionary and BitPacked. With allowLossy, Float16 is chosen when it takes fewer bytes still.
+     */
+    static std::vector<Encoding> chooseEncodings(const DataSource &data, bool allowLossy = false);
+    static std::vector<Encoding> chooseEncodings(const Sample &sample, bool allowLossy = false);
+
+    Eigen::Index rows() const override;
+    Eigen::Index cols() const override;
+    void gatherRows(const int *indices, Eigen::Index count, Sample &out) const override;
+    void copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const override;
+
+    Encoding encoding(Eigen::Index j) const;
+
+    // Bytes used by the encoded columns (compare with rows() * cols() * sizeof(double) for a Sample)
+    size_t memoryBytes() const;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include "types.hpp"
+
+#include <vector>
+#include <cstddef> // For size_t
+#include <atomic>  // For std::atomic (adviseAccess)
+
+/**
+ * Read-only access to the rows of a dataset, used by MoVE and ROVE instead of a Sample.
+ * The ensemble only reads the data by gathering the rows of a subsample or by copying a block of
+ * consecutive rows, so a dataset held in a foreign layout (e.g., Arrow columns, see ArrowDataSource)
+ * can be used without first copying it into a Sample. Base learners still receive Sample objects,
+ * which only hold the rows of a single subsample or block.
+ * All methods must be safe to call concurrently.
+ */
+class DataSource
+{
+public:
+    virtual ~DataSource() = default;
+
+    virtual Eigen::Index rows() const = 0;
+    virtual Eigen::Index cols() const = 0;
+
+    /**
+     * Copy the rows indices[0], ..., indices[count - 1] (in this order) into out, which is resized to
+     * (count, cols()). Indices must be in [0, rows()).
+     */
+    virtual void gatherRows(const int *indices, Eigen::Index count, Sample &out) const = 0;
+
+    // Copy the rows [start, start + count) into out, which is resized to (count, cols()).
+    virtual void copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const;
+
+    /**
+     * Hint the operating system about the access pattern of the calls on this data source: the whole dataset
+     * will be read, so it should be paged in now (MADV_WILLNEED), and, if randomRows, rows are gathered at
+     * random, so readahead is wasted (MADV_RANDOM). This matters when the buffers are a memory-mapped file, whose
+     * pages would otherwise be evicted by the traffic of external storage and fault again during gathers.
+     * Only the first call has an effect, so the dataset is requested once per data source rather than once per
+     * run. Only a hint, errors are ignored.
+     */
+    void adviseAccess(bool randomRows) const;
+
+    DataSource() = default;
+    // Copies are advised again (the flag is not copied)
+    DataSource(const DataSource &) {}
+    DataSource &operator=(const DataSource &) { return *this; }
+
+protected:
+    // Implementation of adviseAccess, called at most once. The default does nothing.
+    virtual void _adviseAccessOnce(bool randomRows) const;
+
+    /**
+     * Helper function for _adviseAccessOnce: advise the parts of [data, data + bytes) that are file-backed
+     * memory mappings (see /proc/self/maps). Heap memory, such as the buffer of a Sample, is left alone.
+     */
+    static void _adviseMappedMemory(const void *data, size_t bytes, bool randomRows);
+
+private:
+    mutable std::atomic<bool> _accessAdvised{false};
+};
+
+/**
+ * DataSource view of a Sample, without copying it.
+ * The sample must outlive the data source.
+ */
+class DenseDataSource : public DataSource
+{
+private:
+    const Sample &_sample;
+
+public:
+    explicit DenseDataSource(const Sample &sample);
+
+    Eigen::Index rows() const override;
+    Eigen::Index cols() const override;
+    void gatherRows(const int *indices, Eigen::Index count, Sample &out) const override;
+    void copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const override;
+};
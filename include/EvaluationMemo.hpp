@@ -0,0 +1,86 @@
+#pragma once
+#include "types.hpp"
+#include "DataSource.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>       // For std::uint64_t
+#include <filesystem>    // For std::filesystem::path
+#include <mutex>         // For std::mutex
+#include <unordered_map> // For the open columns
+
+// Forward declaration of BaseLearner
+struct BaseLearner;
+
+/**
+ * Persistent memo of per-row objective values, shared by ROVE runs (see ROVE::setEvaluationMemo) across calls,
+ * objects and processes.
+ * Repeated runs on the same dataset often retrieve identical candidates, especially with deduplicating learners,
+ * so the objective values of a candidate on a row computed by one run can be reused by the next one.
+ * The memo holds one column file per (dataset fingerprint, candidate hash), at
+ * <directory>/<fingerprint>/<candidate hash>.col, with the objective values of the candidate on every row of
+ * the dataset. A column is memory-mapped; it records which rows have been computed, so a run that evaluates
+ * other rows than the previous ones only computes the missing values.
+ * The memo assumes that BaseLearner::objective only depends on the learner type, the candidate (bit for bit) and
+ * the row. Use separate directories for learners of the same type whose objectives are configured differently.
+ * Each new candidate adds a column of 9 bytes per row of the dataset, so the memo pays off when candidates
+ * repeat across runs; the directory is never pruned by the library.
+ */
+class EvaluationMemo
+{
+public:
+    // A mapped column file
+    struct Column
+    {
+        long long rows = 0;
+        unsigned char *present = nullptr; // 1 if the value of the row is stored
+        double *values = nullptr;
+        void *mapping = nullptr;
+        size_t mappingBytes = 0;
+    };
+
+private:
+    std::filesystem::path _directory;
+
+    /**
+     * _mutex guards _columns and the content of all columns, so that values are never read while another call
+     * of this process writes them. Columns are never unmapped before the destructor, so references stay valid.
+     * Processes that share a directory write identical values, so they are not synchronized.
+     */
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, Column> _columns;
+
+    // Create (or open) the file and map it, must be called with _mutex held
+    static Column _mapColumn(const std::filesystem::path &filePath, std::uint64_t fingerprint,
+                             std::uint64_t candidateHash, long long rows);
+
+public:
+    // Constructor, creates directory if needed
+    explicit EvaluationMemo(const std::string &directory);
+
+    // Destructor, unmaps all columns (the files are kept)
+    ~EvaluationMemo();
+
+    EvaluationMemo(const EvaluationMemo &) = delete;
+    EvaluationMemo &operator=(const EvaluationMemo &) = delete;
+
+    const std::filesystem::path &directory() const;
+
+    // Fingerprint of the content of a dataset (its shape and all values), read in one sequential pass
+    static std::uint64_t fingerprint(const DataSource &data);
+
+    // Hash of a candidate (its bits) and the type of the learner that evaluates it
+    static std::uint64_t candidateHash(const BaseLearner &baseLearner, const Result &candidate);
+
+    // The column of a candidate on a dataset of the given number of rows, created (empty) on first use
+    Column &column(std::uint64_t fingerprint, std::uint64_t candidateHash, long long rows);
+
+    // Whether the values of the column on all rows are stored
+    bool contains(const Column &column, const std::vector<int> &rows) const;
+
+    // Copy the values of the column on rows into out, out[i] is the value on rows[i] (all must be stored)
+    void read(const Column &column, const std::vector<int> &rows, double *out) const;
+
+    // Store values, values[i] is the value on rows[i]
+    void write(Column &column, const std::vector<int> &rows, const double *values);
+};
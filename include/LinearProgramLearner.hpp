@@ -36,9 +36,15 @@ public:
 
     bool isMinimization() const override;
 
+    // The objective is sample * learningResult
+    bool isLinearObjective() const override;
+
     bool enableDeduplication() const override;
 
     bool isDuplicate(const Result &result1, const Result &result2) const override;
+
+    // Single L1-distance pass over the columns of uniqueSet (findDuplicateByL1Distance)
+    Eigen::Index findDuplicate(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet) const override;
 };
 
 // Function for data generation
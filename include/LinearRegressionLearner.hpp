@@ -5,6 +5,17 @@
 #include <Eigen/Dense>
 #include <utility>      // For std::pair
 
+/**
+ * Largest number of features p for which LinearRegressionLearner uses kernels with fixed-size Eigen types
+ * (p x p Gram matrix and LDLT, unrolled products), selected at runtime from a table with one instantiation
+ * per p. Larger p use dynamic-size types. Set it to 0 at compile time to disable the fixed-size kernels.
+ * Every p adds to the compile time of LinearRegressionLearner.cpp (in a Release build, about 80 s with 8
+ * against 40 s without the kernels, and several minutes with 32), while the gain shrinks as p grows.
+ */
+#ifndef VOTE_ENSEMBLE_LR_MAX_FIXED_P
+#define VOTE_ENSEMBLE_LR_MAX_FIXED_P 8
+#endif
+
 // Overload the BaseLearner class for linear regression
 class LinearRegressionLearner : public BaseLearner
 {
@@ -31,6 +42,15 @@ public:
     bool enableDeduplication() const override;
 
     bool isDuplicate(const Result &result1, const Result &result2) const override;
+
+    /**
+     * Incremental learning: the state holds the Gram matrix X^T X and X^T Y of the rows added so far,
+     * which are updated by a rank update for each batch of new rows. While there are fewer rows than
+     * features, the rows themselves are kept as well for the pseudo-inverse (as in learn).
+     */
+    bool supportsIncrementalLearning() const override;
+    std::unique_ptr<IncrementalState> createIncrementalState() const override;
+    Result learnIncremental(IncrementalState &state, const Sample &newRows) override;
 };
 
 // Function for data generation
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>             // For std::atomic
+#include <chrono>             // For timestamps and intervals
+#include <condition_variable> // For waking the flush thread
+#include <cstdint>            // For std::int64_t, std::uint64_t
+#include <functional>         // For std::function (sink)
+#include <memory>             // For std::shared_ptr
+#include <mutex>              // For std::mutex
+#include <sstream>            // For std::ostringstream (VOTE_ENSEMBLE_LOG)
+#include <string>
+#include <thread>             // For the flush thread
+#include <vector>
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off // Only used as a threshold, disables logging
+};
+
+// Name of a level, e.g., "WARNING"
+const char *logLevelName(LogLevel level);
+
+/**
+ * State of one logging call site, created by VOTE_ENSEMBLE_LOG (one static instance per site).
+ * It rate-limits the site without locks: at most Logger::rateLimitBurst messages are admitted per
+ * Logger::rateLimitInterval, and the others are only counted, so a message repeated by many workers
+ * (e.g., for every subsample) is neither formatted nor queued. The next admitted message reports how many
+ * were suppressed.
+ */
+class _LogSite
+{
+private:
+    std::atomic<std::int64_t> _windowStart{0}; // Start of the current window (steady clock, nanoseconds)
+    std::atomic<int> _countInWindow{0};
+    std::atomic<std::uint64_t> _suppressed{0};
+
+public:
+    // Whether a message may be logged now; counts it as suppressed otherwise
+    bool admit(int burst, std::chrono::nanoseconds interval);
+
+    // Number of messages suppressed since the last call (resets the count)
+    std::uint64_t takeSuppressed();
+};
+
+/**
+ * Asynchronous logger of the library.
+ * Calls on worker threads only append the message to a lock-free ring buffer owned by the calling thread
+ * (single producer, single consumer), so logging never serializes workers on a lock of std::cerr. A background
+ * thread drains all buffers every flush interval (and at once for errors), orders the messages by time, collapses
+ * identical consecutive messages, and writes them to the sink (std::cerr by default).
+ * If a buffer is full, the message is dropped and counted, and the next flush reports the number of drops.
+ * Use the VOTE_ENSEMBLE_LOG macro, which skips formatting for disabled levels and rate-limited sites.
+ */
+class Logger
+{
+public:
+    using Sink = std::function<void(LogLevel, const std::string &)>;
+
+    // Messages per thread that can wait for the flush thread
+    static constexpr size_t BUFFER_CAPACITY = 1024;
+
+private:
+    struct Record
+    {
+        std::int64_t time = 0; // Steady clock, nanoseconds
+        LogLevel level = LogLevel::Info;
+        std::string message;
+    };
+
+    // Ring buffer of one thread, head is written by the thread and tail by the flush thread
+    struct _ThreadBuffer
+    {
+        Record records[BUFFER_CAPACITY];
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+    };
+
+    std::atomic<int> _level{static_cast<int>(LogLevel::Warning)};
+    std::atomic<int> _rateLimitBurst{5};
+    std::atomic<std::int64_t> _rateLimitIntervalNanos{std::chrono::nanoseconds(std::chrono::seconds(10)).count()};
+    std::atomic<std::uint64_t> _dropped{0};
+
+    std::mutex _buffersMutex; // Guards _buffers
+    std::vector<std::shared_ptr<_ThreadBuffer>> _buffers;
+
+    std::mutex _sinkMutex; // Guards _sink and serializes flushes
+    Sink _sink;
+
+    std::mutex _flushMutex; // Guards the state of the flush thread below
+    std::condition_variable _flushCondition;
+    std::chrono::milliseconds _flushInterval{100};
+    bool _flushRequested = false;
+    bool _stopping = false;
+    std::thread _flushThread;
+
+    _ThreadBuffer &_localBuffer();
+    void _flushLoop();
+    void _drain();
+
+public:
+    Logger();
+    ~Logger(); // Flushes the remaining messages
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    // The logger used by the library
+    static Logger &global();
+
+    // Messages below level are discarded (default: Warning)
+    void setLevel(LogLevel level);
+    LogLevel level() const;
+    bool isEnabled(LogLevel level) const;
+
+    // At most burst messages per call site and interval are logged (default: 5 per 10 seconds)
+    void setRateLimit(int burst, std::chrono::milliseconds interval);
+
+    // Replace the sink, which is called on the flush thread (default: one line per message on std::cerr)
+    void setSink(Sink sink);
+
+    void setFlushInterval(std::chrono::milliseconds interval);
+
+    // Whether a message at level from site should be formatted and logged (level check, then rate limit)
+    bool shouldLog(LogLevel level, _LogSite &site);
+
+    // Queue a message (use VOTE_ENSEMBLE_LOG instead, which checks shouldLog first)
+    void log(LogLevel level, _LogSite &site, std::string message);
+
+    // Write all queued messages to the sink before returning
+    void flush();
+};
+
+/**
+ * Log a message built with operator<<, e.g., VOTE_ENSEMBLE_LOG(LogLevel::Warning, "k = " << k).
+ * The message is only formatted if the level is enabled and the call site is not rate-limited.
+ */
+#define VOTE_ENSEMBLE_LOG(level, message)                                                                  \
+    do                                                                                                     \
+    {                                                                                                      \
+        static _LogSite voteEnsembleLogSite;                                                               \
+        if (Logger::global().shouldLog(level, voteEnsembleLogSite))                                        \
+        {                                                                                                  \
+            std::ostringstream voteEnsembleLogStream;                                                      \
+            voteEnsembleLogStream << message;                                                              \
+            Logger::global().log(level, voteEnsembleLogSite, voteEnsembleLogStream.str());                 \
+        }                                                                                                  \
+    } while (false)
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>   // For std::atomic
+#include <chrono>   // For std::chrono::steady_clock
+#include <cstdint>  // For std::uint64_t, std::int64_t
+#include <map>      // For the registered metrics, ordered by name
+#include <memory>   // For std::unique_ptr
+#include <mutex>    // For std::mutex
+#include <string>
+#include <thread>   // For the exporter thread
+#include <condition_variable>
+#include <vector>
+
+/**
+ * Runtime metrics of the library, for monitoring long-running processes (throughput and saturation)
+ * without attaching a profiler. All updates are lock-free (relaxed atomics), so they are cheap enough
+ * to be recorded on every call to learn or objective.
+ */
+
+// Monotonically increasing count, e.g., of learned subsamples or written bytes
+class Counter
+{
+private:
+    std::atomic<std::uint64_t> _value{0};
+
+public:
+    void add(std::uint64_t amount = 1);
+    std::uint64_t value() const;
+};
+
+// Value that goes up and down, e.g., the number of queued jobs
+class Gauge
+{
+private:
+    std::atomic<std::int64_t> _value{0};
+
+public:
+    void add(std::int64_t amount);
+    void set(std::int64_t value);
+    std::int64_t value() const;
+
+    // Increment the gauge for the lifetime of the scope, e.g., while a worker is running
+    class Scope
+    {
+    private:
+        Gauge &_gauge;
+
+    public:
+        explicit Scope(Gauge &gauge);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+};
+
+// Distribution of observed values (e.g., latencies in seconds) over fixed buckets
+class Histogram
+{
+private:
+    std::vector<double> _upperBounds;                 // Ascending, the +Inf bucket is implicit
+    std::unique_ptr<std::atomic<std::uint64_t>[]> _bucketCounts; // Per bucket, not cumulative, with +Inf last
+    std::atomic<std::uint64_t> _count{0};
+    std::atomic<double> _sum{0.0};
+
+public:
+    explicit Histogram(std::vector<double> upperBounds = defaultLatencyBounds());
+
+    // Bounds from 1 microsecond to 10 seconds, at 1, 2.5 and 5 per decade
+    static std::vector<double> defaultLatencyBounds();
+
+    void observe(double value);
+
+    const std::vector<double> &upperBounds() const;
+    std::vector<std::uint64_t> cumulativeCounts() const; // One per bound, and the total (+Inf) last
+    std::uint64_t count() const;
+    double sum() const;
+
+    // Observe the seconds elapsed during the lifetime of the timer
+    class Timer
+    {
+    private:
+        Histogram &_histogram;
+        std::chrono::steady_clock::time_point _start;
+
+    public:
+        explicit Timer(Histogram &histogram);
+        ~Timer();
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+    };
+};
+
+/**
+ * Registry of named metrics. Registering a name again returns the existing metric (of the same type,
+ * otherwise std::invalid_argument is thrown), and registered metrics are never removed, so references
+ * to them stay valid for the lifetime of the registry.
+ */
+class MetricsRegistry
+{
+private:
+    enum class Type
+    {
+        Counter,
+        Gauge,
+        Histogram
+    };
+    struct Entry
+    {
+        Type type;
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    mutable std::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+
+    Entry &_register(const std::string &name, const std::string &help, Type type);
+
+public:
+    // The registry used by the library
+    static MetricsRegistry &global();
+
+    Counter &counter(const std::string &name, const std::string &help);
+    Gauge &gauge(const std::string &name, const std::string &help);
+    Histogram &histogram(const std::string &name, const std::string &help,
+                         std::vector<double> upperBounds = Histogram::defaultLatencyBounds());
+
+    /**
+     * Snapshot of all metrics in the Prometheus text exposition format, as read by the textfile collector of
+     * node-exporter. Counter names end in _total, histograms have _bucket, _sum and _count series.
+     */
+    std::string toText() const;
+
+    /**
+     * Write toText() to path atomically: the snapshot is written to a temporary file in the same directory,
+     * which is then renamed to path, so a scraper never reads a partial file.
+     * Throws std::runtime_error if the file cannot be written.
+     */
+    void writeTextfile(const std::string &path) const;
+};
+
+/**
+ * Export a registry periodically to a text file, e.g., "<collector dir>/vote_ensemble.prom" for the textfile
+ * collector of node-exporter. A background thread writes a snapshot every interval, and the destructor
+ * writes a final one. Failed writes are logged (see Logger) and retried at the next interval.
+ */
+class MetricsTextfileExporter
+{
+private:
+    std::string _path;
+    std::chrono::milliseconds _interval;
+    MetricsRegistry &_registry;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping = false;
+    std::thread _thread;
+
+    void _exportLoop();
+
+public:
+    MetricsTextfileExporter(std::string path,
+                            std::chrono::milliseconds interval = std::chrono::seconds(15),
+                            MetricsRegistry &registry = MetricsRegistry::global());
+    ~MetricsTextfileExporter();
+
+    MetricsTextfileExporter(const MetricsTextfileExporter &) = delete;
+    MetricsTextfileExporter &operator=(const MetricsTextfileExporter &) = delete;
+
+    // Write a snapshot now (throws std::runtime_error if the file cannot be written)
+    void exportNow();
+};
+
+/**
+ * The metrics recorded by the library, registered in MetricsRegistry::global() on first use.
+ *   vote_ensemble_subsamples_learned_total:       calls to BaseLearner::learn (and learnIncremental)
+ *   vote_ensemble_learn_seconds:                  latency of those calls (including abandoned ones)
+ *   vote_ensemble_replaced_subsamples_total:      subsamples replaced after exceeding the learn deadline
+ *   vote_ensemble_objective_seconds:              latency of calls to BaseLearner::objective
+ *   vote_ensemble_evaluation_rows_total:          rows on which the candidates were evaluated
+ *   vote_ensemble_evaluation_cache_hits_total:    subsample rows whose objective values came from the cache
+ *   vote_ensemble_evaluation_memo_hits_total:     candidates whose objective values came from the EvaluationMemo
+ *   vote_ensemble_storage_written_bytes_total:    bytes written by _SubsampleResultIO
+ *   vote_ensemble_storage_read_bytes_total:       bytes read by _SubsampleResultIO
+ *   vote_ensemble_async_queue_depth:              runAsync jobs waiting for a pool thread
+ *   vote_ensemble_async_running_jobs:             runAsync jobs in progress
+ *   vote_ensemble_active_workers:                 learning and evaluation workers in progress
+ */
+struct _LibraryMetrics
+{
+    Counter &subsamplesLearned;
+    Counter &replacedSubsamples;
+    Histogram &learnSeconds;
+    Histogram &objectiveSeconds;
+    Counter &evaluationRows;
+    Counter &evaluationCacheHits;
+    Counter &evaluationMemoHits;
+    Counter &storageWrittenBytes;
+    Counter &storageReadBytes;
+    Gauge &asyncQueueDepth;
+    Gauge &asyncRunningJobs;
+    Gauge &activeWorkers;
+
+    static _LibraryMetrics &get();
+};
@@ -7,6 +7,7 @@
 #include <optional> // For std::optional
 #include <variant>  // For std::variant
 #include <utility>  // For std::pair
+#include <future>   // For std::future
 
 class MoVE : public _BaseVE
 {
@@ -14,11 +15,8 @@ private:
      // Helper function to finalize the choice for B and k
      std::pair<int, int> _chooseParameters(long long n, int B_in, std::optional<int> k_in) const;
 
-     /**
-      * Helper function to implement the majority voting process in MoVE
-      * Returns the index of the most frequent candidate in learningResults.
-      */
-     size_t _performMajorityVoting(const std::vector<std::variant<Result, int>> &learningResults);
+     // Implementation of run, which stops early once cancellation (if not null) is requested
+     Result _run(const DataSource &data, int B, std::optional<int> k, const CancellationToken *cancellation);
 
 public:
      // Constructor
@@ -26,10 +24,11 @@ public:
           int numParallelLearn = 1,
           std::optional<unsigned int> randomSeed = std::nullopt,
           const std::optional<std::string> &subsampleResultsDir = std::nullopt,
-          bool deleteSubsampleResults = true);
+          bool deleteSubsampleResults = true,
+          StorageLayout storageLayout = StorageLayout::Compressed);
 
-     // Destructor
-     ~MoVE() override = default;
+     // Destructor, waits for the jobs of runAsync
+     ~MoVE() override;
 
      // run function with all parameters specified
      virtual Result run(const Sample &sample,
@@ -38,4 +37,35 @@ public:
 
      // Override the run function from _BaseVE (run under default parameters)
      Result run(const Sample &sample) override;
+
+     // run function on a DataSource (e.g., ArrowDataSource), without copying the data into a Sample
+     Result run(const DataSource &data,
+                int B = 50,
+                std::optional<int> k = std::nullopt);
+
+     /**
+      * Start run on the pool of this object (see setNumAsyncWorkers) and return at once.
+      * The future holds the result, or the exception of the run (OperationCancelled once cancellation is
+      * requested through a copy of the token). The Sample overload keeps its own copy of the sample (moved in
+      * if the caller passes an rvalue). The DataSource overload only keeps a reference to data, which the caller
+      * must keep alive until the future is ready. The object must outlive the future, its destructor waits for
+      * all jobs.
+      */
+     std::future<Result> runAsync(Sample sample,
+                                  int B = 50,
+                                  std::optional<int> k = std::nullopt,
+                                  CancellationToken cancellation = CancellationToken());
+     std::future<Result> runAsync(const DataSource &data,
+                                  int B = 50,
+                                  std::optional<int> k = std::nullopt,
+                                  CancellationToken cancellation = CancellationToken());
+
+     /**
+      * Run MoVE for every subsample size in kGrid with B nested subsamples each: the b-th subsample of a size
+      * extends the b-th subsample of the next smaller size. Base learners that support incremental learning
+      * only learn on the added rows. The result holds the majority vote for every size and every prefix of
+      * the B subsamples, at about the cost of a single run with the largest size.
+      */
+     SweepResult runSweep(const Sample &sample, const std::vector<int> &kGrid, int B = 200);
+     SweepResult runSweep(const DataSource &data, const std::vector<int> &kGrid, int B = 200);
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <future> // For std::future
+#include <memory> // For std::shared_ptr
 
 // Forward declaration of classes
 class _CachedEvaluator;
@@ -14,7 +16,13 @@ class ROVE : public _BaseVE
 {
 private:
     bool _dataSplit;
-    int _numParallelEval;
+    int _numParallelEval; // Chosen by autoThreadConfig if the constructor receives a value <= 0
+
+    // A run uses numParallelLearn threads in Phase I and numParallelEval threads in Phase II
+    int _numThreadsPerRun() const override;
+
+    // Evaluation memo shared across runs (null if disabled), see setEvaluationMemo
+    std::shared_ptr<EvaluationMemo> _evaluationMemo;
 
     // Struct to hold calculated parameters for a ROVE run
     struct ROVERunParameters
@@ -27,6 +35,13 @@ private:
     ROVERunParameters _chooseParameters(long long nTotal, int B1_in, int B2_in,
                                         std::optional<int> k1_in,
                                         std::optional<int> k2_in) const;
+
+    // Implementation of run, which stops early once cancellation (if not null) is requested
+    Result _run(const DataSource &data, int B1, int B2, std::optional<int> k1, std::optional<int> k2,
+                double epsilon, double autoEpsilonProb, const CancellationToken *cancellation);
+
+    // Helper function to compute the work of a call (see _BaseVE::_beginRun), k1Total is the sum of the Phase I sizes
+    static double _work(long long nTotal, const ROVERunParameters &params, long long k1Total);
     /**
      * Helper method to compute the gap matrix
      * The gap matrix has the same dimension as the evaluation matrix, returned by
@@ -36,20 +51,112 @@ private:
      */
     Matrix _gapMatrix(const Matrix &evalArray);
 
-    // Perform Phase I learning on subsamples to retrieve candidate solutions
-    std::pair<std::vector<std::variant<Result, int>>, std::vector<std::variant<Result, int>>>
-    _runPhaseOneLearning(const Sample &sample, const ROVERunParameters &params);
+    /**
+     * Perform Phase I learning on subsamples to retrieve candidate solutions
+     * Returns 1. The learning results of all B1 subsamples.
+     *         2. The learning results grouped by duplicates. uniqueIndices are the indices of the retrieved
+     *            candidates in the learning results. Without deduplication, all learning results are
+     *            retrieved, each with a count of 1.
+     */
+    std::pair<std::vector<std::variant<Result, int>>, _DuplicateGroups>
+    _runPhaseOneLearning(_RunContext &context, const DataSource &data, const ROVERunParameters &params);
+
+    /**
+     * Helper method to retrieve the candidates among the count learning results starting at first,
+     * i.e., group them by duplicates if deduplication is enabled, and retrieve all of them otherwise.
+     */
+    _DuplicateGroups _retrieveCandidates(_RunContext &context,
+                                         const std::vector<std::variant<Result, int>> &learningResults,
+                                         size_t first, size_t count);
+
+    /**
+     * Helper method to evaluate the candidates of cachedEvaluator on B2 subsamples of size k2,
+     * drawn from the rows [start, start + size) of the sample.
+     * _evaluateCandidates returns the evaluation matrix and _evaluateGapMatrix returns the gap matrix.
+     */
+    Matrix _evaluateCandidates(_RunContext &context, _CachedEvaluator &cachedEvaluator,
+                               long long start, long long size, const ROVERunParameters &params);
+    Matrix _evaluateGapMatrix(_RunContext &context, _CachedEvaluator &cachedEvaluator,
+                              long long start, long long size, const ROVERunParameters &params);
+
+    /**
+     * Helper method to select the candidate with the maximum epsilon-optimal probability on gapMatrixPhaseTwo.
+     * If epsilon < 0, it is determined from autoEpsilonProb, on gapMatrixPhaseOne when dataSplit is enabled
+     * (which must then be nonempty) and on gapMatrixPhaseTwo otherwise.
+     */
+    size_t _selectCandidate(const Matrix &gapMatrixPhaseTwo, const Matrix &gapMatrixPhaseOne,
+                            double epsilon, double autoEpsilonProb) const;
 
     /**
      * Perform Phase II evaluation of retrieved candidates
-     * Return the index of the selected candidate in the retrievedResults.
+     * Return the index of the selected candidate among the candidates of cachedEvaluator.
      */
-    size_t _runPhaseTwoEvaluation(const std::vector<std::variant<Result, int>> &retrievedResults,
-                                  double epsilon, double autoEpsilonProb,
+    size_t _runPhaseTwoEvaluation(_RunContext &context, double epsilon, double autoEpsilonProb,
                                   _CachedEvaluator &cachedEvaluator,
                                   const ROVERunParameters &params);
 
 public:
+    /**
+     * The epsilon-probability profile of a ROVE run, returned by ROVE::runProfile.
+     * For each candidate, it holds the sorted distribution of its gaps over the B2 evaluation subsamples.
+     * Since the probability of a candidate being epsilon-optimal is the fraction of gaps that are at most
+     * epsilon, the selection for any epsilon or autoEpsilonProb can be read off in O(num_candidates * log(B2))
+     * without new learning or evaluation.
+     */
+    class EpsilonProfile
+    {
+    private:
+        // Candidate solutions retrieved in Phase I
+        std::vector<Result> _candidates;
+
+        /**
+         * Gap matrices of size (B2, num_candidates), where each column is sorted in ascending order.
+         * _sortedGaps is computed on Phase II data and is used for the selection.
+         * _sortedEpsilonGaps is computed on Phase I data and is used to determine epsilon when dataSplit
+         * is enabled. It is empty otherwise, in which case _sortedGaps is used instead.
+         */
+        Matrix _sortedGaps;
+        Matrix _sortedEpsilonGaps;
+
+        // Number of gaps in column of sortedGaps that are smaller than or equal to epsilon
+        static Eigen::Index _countWithin(const Matrix &sortedGaps, Eigen::Index column, double epsilon);
+
+    public:
+        EpsilonProfile(std::vector<Result> candidates, Matrix gapMatrix, Matrix epsilonGapMatrix = Matrix());
+
+        size_t numCandidates() const;
+        const Result &candidate(size_t candidateIndex) const;
+
+        // The sorted gaps (on Phase II data), column c is the gap distribution of the c-th candidate.
+        const Matrix &sortedGaps() const;
+
+        // Same as ROVE::_epsilonOptimalProb applied to the Phase II gap matrix.
+        RowVector epsilonOptimalProb(double epsilon) const;
+
+        /**
+         * The smallest epsilon for which the maximum epsilon-optimal probability is at least autoEpsilonProb.
+         * This is the exact value approximated by ROVE::_findEpsilon through bisection.
+         */
+        double findEpsilon(double autoEpsilonProb) const;
+
+        // Index of the candidate selected under the given epsilon (epsilon < 0 is not allowed).
+        size_t selectIndex(double epsilon) const;
+
+        // Index of the candidate selected when epsilon is chosen automatically from autoEpsilonProb.
+        size_t selectIndexAuto(double autoEpsilonProb) const;
+
+        const Result &select(double epsilon) const;
+        const Result &selectAuto(double autoEpsilonProb) const;
+    };
+
+    // Result of ROVE::runWithMoVE
+    struct MoVEAndROVEResult
+    {
+        Result moveResult;    // Majority vote over the Phase I learning results (as MoVE::run)
+        Result roveResult;    // Epsilon-optimal vote over the retrieved candidates (as ROVE::run)
+        size_t numCandidates; // Number of distinct candidates retrieved in Phase I
+    };
+
     // Constructor
     ROVE(BaseLearner *baseLearner,
          bool dataSplit = false,
@@ -57,10 +164,20 @@ public:
          int numParallelLearn = 1,
          std::optional<unsigned int> randomSeed = std::nullopt,
          const std::optional<std::string> &subsampleResultsDir = std::nullopt,
-         bool deleteSubsampleResults = true);
+         bool deleteSubsampleResults = true,
+         StorageLayout storageLayout = StorageLayout::Compressed);
+
+    // Destructor, waits for the jobs of runAsync
+    ~ROVE() override;
 
-    // Destructor
-    ~ROVE() override = default;
+    /**
+     * Reuse the per-row objective values of Phase II across runs through memo (null disables it, the default).
+     * Candidates found in the memo are not evaluated again on the rows it holds, and the values computed by a
+     * run are added to it. The memo can be shared by several objects (and, through its directory, processes).
+     * It is skipped for learners with a linear objective, whose evaluation is already a matrix product.
+     * Must not be called concurrently with run.
+     */
+    void setEvaluationMemo(std::shared_ptr<EvaluationMemo> memo);
 
     /**
      * Helper method to compute the probability of each candidate being epsilon-optimal
@@ -82,4 +199,76 @@ public:
 
     // Override the run function from _BaseVE (run under default parameters)
     Result run(const Sample &sample) override;
+
+    // run function on a DataSource (e.g., ArrowDataSource), without copying the data into a Sample
+    Result run(const DataSource &data,
+               int B1 = 50, int B2 = 200,
+               std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt,
+               double epsilon = -1.0, double autoEpsilonProb = 0.5);
+
+    /**
+     * Start run on the pool of this object (see setNumAsyncWorkers) and return at once.
+     * The future holds the result, or the exception of the run (OperationCancelled once cancellation is
+     * requested through a copy of the token). The Sample overload keeps its own copy of the sample (moved in
+     * if the caller passes an rvalue). The DataSource overload only keeps a reference to data, which the caller
+     * must keep alive until the future is ready. The object must outlive the future, its destructor waits for
+     * all jobs.
+     */
+    std::future<Result> runAsync(Sample sample,
+                                 int B1 = 50, int B2 = 200,
+                                 std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt,
+                                 double epsilon = -1.0, double autoEpsilonProb = 0.5,
+                                 CancellationToken cancellation = CancellationToken());
+    std::future<Result> runAsync(const DataSource &data,
+                                 int B1 = 50, int B2 = 200,
+                                 std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt,
+                                 double epsilon = -1.0, double autoEpsilonProb = 0.5,
+                                 CancellationToken cancellation = CancellationToken());
+
+    /**
+     * Run Phase I and the Phase II evaluation once, and return the epsilon-probability profile.
+     * The profile can then be queried for any epsilon or autoEpsilonProb. The parameters have the
+     * same meaning as in run.
+     */
+    EpsilonProfile runProfile(const Sample &sample,
+                              int B1 = 50, int B2 = 200,
+                              std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt);
+    EpsilonProfile runProfile(const DataSource &data,
+                              int B1 = 50, int B2 = 200,
+                              std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt);
+
+    /**
+     * Run Phase I once and return both the MoVE and the ROVE solution from the shared learning results.
+     * This requires deduplication and no data splitting, in which case MoVE with B = B1 and k = k1 draws
+     * its subsamples in the same way as Phase I of ROVE. With the same random seed, moveResult then equals
+     * the result of MoVE::run(sample, B1, k1), and roveResult equals the result of ROVE::run.
+     */
+    MoVEAndROVEResult runWithMoVE(const Sample &sample,
+                                  int B1 = 50, int B2 = 200,
+                                  std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt,
+                                  double epsilon = -1.0, double autoEpsilonProb = 0.5);
+    MoVEAndROVEResult runWithMoVE(const DataSource &data,
+                                  int B1 = 50, int B2 = 200,
+                                  std::optional<int> k1 = std::nullopt, std::optional<int> k2 = std::nullopt,
+                                  double epsilon = -1.0, double autoEpsilonProb = 0.5);
+
+    /**
+     * Run ROVE for every Phase I subsample size in k1Grid with B1 nested subsamples each: the b-th subsample
+     * of a size extends the b-th subsample of the next smaller size. Base learners that support incremental
+     * learning only learn on the added rows. The candidates of all sizes are evaluated together on the same
+     * Phase II subsamples, so the sizes are compared under common random numbers. The result holds the ROVE
+     * selection for every size and every prefix of the B1 subsamples. The other parameters have the same
+     * meaning as in run.
+     * The selection of a prefix is computed from scratch, as run would compute it for those subsamples, but
+     * only for the prefixes that add a candidate. For a size with U distinct candidates, this costs up to U
+     * selections on at most U candidates each, i.e., O(U^2 * B2) per step of the bisection of epsilon (when
+     * it is chosen automatically), instead of O(U * B2) for a single run. U is at most B1 (e.g., learners
+     * without deduplication), and this is usually small next to the learning and the evaluation.
+     */
+    SweepResult runSweep(const Sample &sample, const std::vector<int> &k1Grid,
+                         int B1 = 50, int B2 = 200, std::optional<int> k2 = std::nullopt,
+                         double epsilon = -1.0, double autoEpsilonProb = 0.5);
+    SweepResult runSweep(const DataSource &data, const std::vector<int> &k1Grid,
+                         int B1 = 50, int B2 = 200, std::optional<int> k2 = std::nullopt,
+                         double epsilon = -1.0, double autoEpsilonProb = 0.5);
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+#include "BaseLearner.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <string>
+
+/**
+ * Distribution of a synthetic cost.
+ * Constant: every call costs medianMicros.
+ * LogNormal: log(cost) is normal with median medianMicros and standard deviation sigma.
+ * Stragglers: every call costs medianMicros, except that with probability stragglerProb it
+ *             costs stragglerFactor times more (e.g., a pathological subsample of an iterative solver).
+ */
+enum class CostDistribution
+{
+    Constant,
+    LogNormal,
+    Stragglers
+};
+
+struct CostModel
+{
+    CostDistribution distribution = CostDistribution::Constant;
+    double medianMicros = 0.0;
+    double sigma = 1.0;             // Only used by LogNormal
+    double stragglerProb = 0.01;    // Only used by Stragglers
+    double stragglerFactor = 100.0; // Only used by Stragglers
+
+    // Draw a cost in microseconds
+    double draw(std::mt19937_64 &rng) const;
+};
+
+// Configuration of SyntheticLearner
+struct SyntheticLearnerConfig
+{
+    // Cost of one call to learn
+    CostModel learnCost;
+
+    // Cost of one call to objective, per evaluated row
+    CostModel objectiveCostPerRow;
+
+    // Length of each Result
+    Eigen::Index resultSize = 8;
+
+    /**
+     * Probability that learn returns one of numDuplicateCandidates shared results, instead of
+     * a unique result. Controls the number of distinct candidates in MoVE and ROVE.
+     */
+    double duplicateRate = 0.0;
+    int numDuplicateCandidates = 4;
+    bool enableDeduplication = false;
+
+    /**
+     * Size of one serialized result in bytes (the result itself plus incompressible padding).
+     * Values smaller than the size of the result itself are ignored.
+     */
+    size_t serializedBytes = 0;
+
+    // Seed mixed into all random draws
+    std::uint64_t seed = 0;
+};
+
+/**
+ * A learner whose costs and outputs follow a configurable model, without doing any real math.
+ * It is used to benchmark scheduling, storage and voting independently of the learning problem.
+ * Costs are simulated by busy-waiting, so they occupy a CPU like real work does.
+ *
+ * All random draws of learn are seeded from the content of the subsample, so a run is reproducible
+ * and independent of thread scheduling. The sample may have any number of columns.
+ */
+class SyntheticLearner : public BaseLearner
+{
+private:
+    SyntheticLearnerConfig _config;
+
+    // Tolerance for the duplicate check
+    const double tolerance = 1e-9;
+
+    // Seed derived from the content of the sample and the configured seed
+    std::uint64_t _sampleSeed(const Sample &sample) const;
+
+    // Implementation of learn and learnCancellable (cancellation is null for learn)
+    Result _learn(const Sample &sample, const CancellationToken *cancellation);
+
+public:
+    // Constructor
+    explicit SyntheticLearner(const SyntheticLearnerConfig &config);
+
+    // Destructor
+    ~SyntheticLearner() override = default;
+
+    const SyntheticLearnerConfig &config() const;
+
+    Result learn(const Sample &sample) override;
+
+    // Polls cancellation while busy-waiting, so a straggler is abandoned at the learn deadline
+    Result learnCancellable(const Sample &sample, const CancellationToken &cancellation) override;
+
+    // Returns (row sum - result sum)^2 for each row of the sample
+    Vector objective(const Result &learningResult, const Sample &sample) const override;
+
+    bool isMinimization() const override;
+
+    bool enableDeduplication() const override;
+
+    bool isDuplicate(const Result &result1, const Result &result2) const override;
+
+    // Single L1-distance pass over the columns of uniqueSet (findDuplicateByL1Distance)
+    Eigen::Index findDuplicate(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet) const override;
+
+    // Serialization, padded to config().serializedBytes
+    void dumpLearningResult(const Result &learningResult, std::ostream &out) const override;
+    Result loadLearningResult(std::istream &in) const override;
+};
+
+// Busy-wait for the given number of microseconds
+void spinForMicros(double micros);
+
+// Busy-wait as above, throw OperationCancelled (with caller in the message) once cancellation is cancelled
+void spinForMicros(double micros, const CancellationToken &cancellation, const std::string &caller);
+
+// Function for data generation (standard normal entries)
+Sample generateSyntheticData(size_t n, int p, unsigned int seed);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <future> // For std::launch
+
+/**
+ * Passing this value (or any value <= 0) as the number of parallel learners or evaluators
+ * lets the library choose it with autoThreadConfig.
+ */
+constexpr int AUTO_NUM_THREADS = 0;
+
+/**
+ * Automatic thread configuration, based on the CPUs that are actually available to the process.
+ * On Linux, the following are taken into account:
+ *   1. The CPU affinity mask (e.g., taskset, cpuset cgroups).
+ *   2. The CPU quota of the cgroup (v2: cpu.max, v1: cpu.cfs_quota_us / cpu.cfs_period_us).
+ *   3. SMT siblings, to count physical cores.
+ * On other platforms, std::thread::hardware_concurrency is used.
+ * The environment variable VOTE_ENSEMBLE_NUM_THREADS, if set to a positive integer, overrides the
+ * chosen worker counts of both phases.
+ */
+struct ThreadConfig
+{
+    // Number of CPUs available to the process (after affinity and quota), at least 1.
+    int availableCpus = 1;
+
+    // Number of physical cores among the available CPUs (SMT siblings count once), at least 1.
+    int physicalCores = 1;
+
+    /**
+     * Chosen worker counts per phase.
+     * Learning is compute bound, so it uses one worker per physical core, since SMT siblings share the
+     * floating-point units. Evaluation gathers sample rows and is bound by memory latency, which SMT helps
+     * to hide, so it uses all available CPUs.
+     */
+    int numParallelLearn = 1;
+    int numParallelEval = 1;
+
+    // Human-readable summary, e.g., for logging.
+    std::string toString() const;
+};
+
+/**
+ * Detect the thread configuration of the current process.
+ * The detection runs once, later calls return the cached result.
+ */
+const ThreadConfig &autoThreadConfig();
+
+/**
+ * Launch policy for the tasks of numWorkers parallel workers (passed to std::async).
+ * A single worker runs on the calling thread when its future is waited on, so no thread is started for it.
+ */
+inline std::launch launchPolicyFor(int numWorkers)
+{
+    return numWorkers > 1 ? std::launch::async : std::launch::deferred;
+}
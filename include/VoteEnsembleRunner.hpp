@@ -2,11 +2,15 @@
 #include "types.hpp"
 #include "MoVE.hpp"
 #include "ROVE.hpp"
+#include "ThreadConfig.hpp"
 
 #include <string>
 #include <optional> // For std::optional
 
-// Function to run MoVE with specified parameters and results printing
+/**
+ * Function to run MoVE with specified parameters and results printing
+ * numThreads <= 0 (e.g., AUTO_NUM_THREADS) lets autoThreadConfig choose the number of threads.
+ */
 void runMoVE(
     const std::string &experimentName,
     BaseLearner *baseLearnerPtr,
@@ -18,7 +22,10 @@ void runMoVE(
     int B = 200,
     std::optional<int> k = std::nullopt);
 
-// Function to run ROVE with specified parameters and results printing
+/**
+ * Function to run ROVE with specified parameters and results printing
+ * numThreads <= 0 (e.g., AUTO_NUM_THREADS) lets autoThreadConfig choose the number of threads per phase.
+ */
 void runROVE(
     const std::string &experimentName,
     BaseLearner *baseLearnerPtr,
@@ -33,4 +40,24 @@ void runROVE(
     std::optional<int> k1 = std::nullopt,
     std::optional<int> k2 = std::nullopt,
     double epsilon = -1.0,
+    double autoEpsilonProb = 0.5);
+
+/**
+ * Function to run MoVE and ROVE with shared Phase I learning (ROVE::runWithMoVE) and results printing
+ * MoVE uses B = B1 and k = k1. The base learner must enable deduplication, and data splitting is disabled.
+ * numThreads <= 0 (e.g., AUTO_NUM_THREADS) lets autoThreadConfig choose the number of threads per phase.
+ */
+void runMoVEAndROVE(
+    const std::string &experimentName,
+    BaseLearner *baseLearnerPtr,
+    const Sample &sample,
+    int numThreads,
+    unsigned int seed,
+    const std::optional<std::string> &subsampleResultsDir = std::nullopt, // Default to no external storage.
+    bool deleteSubsampleResults = true,
+    int B1 = 50,
+    int B2 = 200,
+    std::optional<int> k1 = std::nullopt,
+    std::optional<int> k2 = std::nullopt,
+    double epsilon = -1.0,
     double autoEpsilonProb = 0.5);
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "types.hpp"
+#include "DataSource.hpp"
+#include "CancellationToken.hpp"
 
 #include <vector>
 #include <string>
@@ -8,15 +10,23 @@
 #include <memory>   // For std::unique_ptr
 #include <variant>  // For std::variant
 #include <future>   // For std::async, std::future
+#include <atomic>   // For std::atomic (call ids)
+#include <limits>   // For std::numeric_limits
+#include <mutex>    // For std::mutex (async pool)
+#include <functional> // For std::function
+#include <chrono>   // For std::chrono::microseconds (learn deadline)
 
 // Forward declaration of classes
 struct BaseLearner;
 class _SubsampleResultIO; // Used in _learnOnSubsamples and _loadResultIfNeeded
+class _ThreadPool;        // Runs the jobs of runAsync
 
 /**
  * _BaseVE stands for Base VoteEnsemble, which serves as the base class for main algorithms MoVE and ROVE.
  * Note that in the current implementation, _BaseVE, MoVE, and ROVE do not
  * hold sample as a member variable. Instead, they are passed as arguments to the run function.
+ * The run functions are reentrant: all state of a call lives in its _RunContext, so one object can serve
+ * concurrent calls (the base learner must then support concurrent calls, as it already does for parallel learning).
  */
 class _BaseVE
 {
@@ -24,15 +34,32 @@ protected: // Ensure those members are accessible to derived classes (MoVE and R
     // Pointer to the base learner.
     BaseLearner *_baseLearner;
 
-    // Number of parallel learners.
+    // Number of parallel learners (chosen by autoThreadConfig if the constructor receives a value <= 0).
     int _numParallelLearn;
 
-    // Random number generator.
-    std::mt19937 _rng;
+    // Random seed, from which the random number generator of each call is derived.
     unsigned int _randomSeed;
 
-    // Pointer to the _SubsampleResultIO class, which can be used by derived classes.
-    std::unique_ptr<_SubsampleResultIO> _subsampleResultIO;
+    // Id of the next call to run (or another entry point), see _beginRun.
+    std::atomic<unsigned long long> _nextCallId{0};
+
+    // Number of consecutive rows drawn together in a subsample (1 for uniform row sampling), see setSubsampleBlockSize
+    int _subsampleBlockSize = 1;
+
+    // Calls with at most this much work (see _beginRun) run inline on the calling thread, see setSmallProblemThreshold
+    double _smallProblemThreshold = DEFAULT_SMALL_PROBLEM_THRESHOLD;
+
+    // Deadline of a single call to learn in _learnOnSubsamples (0 disables it), see setLearnDeadline
+    std::chrono::microseconds _learnDeadline{0};
+    int _maxReplacementsPerSubsample = DEFAULT_MAX_REPLACEMENTS_PER_SUBSAMPLE;
+
+    // Subsamples abandoned after exceeding the learn deadline, over all calls, see numReplacedSubsamples
+    std::atomic<unsigned long long> _numReplacedSubsamples{0};
+
+    // Configuration of the external storage, from which the _SubsampleResultIO of each call is created.
+    std::optional<std::string> _subsampleResultsDir;
+    StorageLayout _storageLayout;
+    bool _directStorageIO = false;
 
     /**
      * Flag to indicate whether to delete intermediate computation results.
@@ -40,23 +67,150 @@ protected: // Ensure those members are accessible to derived classes (MoVE and R
      */
     bool _deleteSubsampleResults;
 
+    // Run directory of the last call that stored its results externally, see lastRunDir
+    mutable std::mutex _lastRunDirMutex;
+    std::optional<std::string> _lastRunDir;
+
+    /**
+     * Pool that runs the jobs of runAsync, started by the first call to runAsync with _numAsyncWorkers
+     * threads (chosen as described in setNumAsyncWorkers if <= 0). _asyncPoolMutex guards its creation.
+     */
+    int _numAsyncWorkers = 0;
+    std::mutex _asyncPoolMutex;
+    std::unique_ptr<_ThreadPool> _asyncPool;
+
+    /**
+     * State of a single call to run (or another entry point), created by _beginRun and passed to the helper
+     * functions. Calls only share the configuration of the object, which is not modified by them, so one
+     * object can serve concurrent calls from many threads.
+     * rng is derived from the random seed and callId. subsampleResultIO stores the learning results of this
+     * call only, in its own namespace directory (see _SubsampleResultIO), so storage indices never collide.
+     * Unless the results are kept (deleteSubsampleResults = false), the directory is removed with the context,
+     * so a call that throws does not leave the results it already dumped behind.
+     * inlineExecution marks a small problem, which runs on the calling thread with in-memory results.
+     * cancellation is the token of a call started by runAsync, and null otherwise.
+     */
+    struct _RunContext
+    {
+        unsigned long long callId = 0;
+        std::mt19937 rng;
+        std::unique_ptr<_SubsampleResultIO> subsampleResultIO;
+        bool inlineExecution = false;
+        const CancellationToken *cancellation = nullptr;
+    };
+
+    /**
+     * Helper function to start a call: take the next call id and create its context.
+     * Call 0 seeds its rng with the random seed itself, so a single call per object draws the same subsamples
+     * as before calls were separated. Later calls seed theirs from (random seed, call id).
+     * work is the total number of subsample rows the call learns on and evaluates (e.g., n * B * k for MoVE,
+     * where each subsample row is counted once per row of the evaluation sample). If it does not exceed the
+     * small problem threshold, the call runs inline: the results are kept in memory even if a storage directory
+     * is configured (so no directory is created), and no threads are started.
+     */
+    _RunContext _beginRun(double work, const CancellationToken *cancellation = nullptr);
+
+    /**
+     * Helper function to advise the access pattern of a call on data (see DataSource::adviseAccess), unless
+     * it runs inline. Rows are gathered at random, unless subsamples are drawn in blocks (see
+     * setSubsampleBlockSize) or sequentialScan is set (e.g., ROVE's full-scan evaluation), which keep readahead.
+     */
+    void _adviseDataAccess(const _RunContext &context, const DataSource &data, bool sequentialScan = false) const;
+
+    // Helper function to check whether cancellation of a call was requested
+    static bool _isCancelled(const _RunContext &context);
+
+    /**
+     * Helper function to stop a cancelled call: if cancellation was requested, clean up learningResults
+     * (as _cleanupSubsampleResults) and throw OperationCancelled. Otherwise, do nothing.
+     */
+    void _stopIfCancelled(_RunContext &context, const std::vector<std::variant<Result, int>> &learningResults,
+                          const std::string &caller);
+
+    // Number of worker threads of a single call that does not run inline, used to size the async pool
+    virtual int _numThreadsPerRun() const;
+
+    /**
+     * Helper function to run job on the async pool (started on first use), used by runAsync.
+     * The returned future holds the result of job, or the exception it threw.
+     */
+    std::future<Result> _submitAsync(std::function<Result()> job);
+
+    /**
+     * Helper function to stop the async pool: the queued jobs still run, and the call returns once all
+     * have finished. Derived classes call it in their destructor, since the jobs use their members.
+     */
+    void _stopAsyncPool();
+
+    // Helper function to get the number of workers of a call, at most numParallel and at most numTasks (1 if inline)
+    static int _numWorkers(const _RunContext &context, int numParallel, int numTasks = std::numeric_limits<int>::max());
+
     /**
      * Helper function to to get a candidate solution as Result.
-     * Ensure the output is Result. If the input is the index, load the result from external storage.
+     * If the input holds a Result, a reference to it is returned and no copy is made.
+     * If the input is the index, the result is loaded from external storage into buffer,
+     * and a reference to buffer is returned. The reference is valid as long as both
+     * resultOrIndex and buffer are alive and unmodified.
      */
-    Result _loadResultIfNeeded(const std::variant<Result, int> &resultOrIndex);
+    const Result &_loadResultIfNeeded(_RunContext &context, const std::variant<Result, int> &resultOrIndex, Result &buffer);
 
-    // Helper function to generate B sets of subsample indices, each of size k.
-    std::vector<std::vector<int>> _generateSubsampleIndices(int n, int k, int B);
+    /**
+     * Helper function to generate B sets of subsample indices, each of size k, in ascending order.
+     * With a subsample block size above 1, each set is a union of random blocks of consecutive rows.
+     */
+    std::vector<std::vector<int>> _generateSubsampleIndices(_RunContext &context, int n, int k, int B);
 
     /**
      * Helper function to learn on a single subsample.
-     * Receive the full sample and the indices to the subsample.
+     * Receive the full data and the indices to the subsample, the rows are gathered into buffer, which a
+     * worker reuses for all its subsamples. n is the number of rows that replacement subsamples are drawn
+     * from (see _learnWithDeadline).
      * Return a Result or an int (index of the result).
      */
-    std::variant<Result, int> _processSingleSubsample(const Sample &sample,
+    std::variant<Result, int> _processSingleSubsample(_RunContext &context,
+                                                      const DataSource &data,
+                                                      long long n,
                                                       const std::vector<int> &indices,
-                                                      int subsampleIndex);
+                                                      int subsampleIndex,
+                                                      Sample &buffer);
+
+    /**
+     * Helper function to learn on the rows in buffer under the learn deadline.
+     * If the base learner abandons the subsample (throws OperationCancelled from learnCancellable) because the
+     * deadline has passed, a replacement subsample of the same size is drawn from the first n rows of data
+     * and learned instead. Its rows are drawn from an rng seeded by (random seed, call id, subsampleIndex,
+     * attempt), so they do not depend on the order in which the workers run. After the configured number of
+     * replacements, the last subsample is learned without a deadline, so every subsample yields a result.
+     * OperationCancelled is rethrown if the call itself is cancelled.
+     */
+    Result _learnWithDeadline(_RunContext &context, const DataSource &data, long long n, int subsampleIndex,
+                              Sample &buffer);
+    /**
+     * Helper function to store a learning result, depending on whether the external storage is enabled.
+     * Return the result itself or its index in the external storage (storageIndex).
+     */
+    std::variant<Result, int> _storeLearningResult(_RunContext &context, Result learningResult, int storageIndex);
+
+    /**
+     * Helper function to generate B sequences of kMax distinct indices in [0, n) by a partial Fisher-Yates shuffle.
+     * For every k <= kMax, the first k indices of a sequence form a uniform subsample of size k, so the
+     * subsamples of different sizes are nested. With a subsample block size above 1, each sequence is made of
+     * random blocks of consecutive rows (see _sampleBlockPositions), which keeps the subsamples nested.
+     */
+    std::vector<std::vector<int>> _generateNestedSubsampleIndices(_RunContext &context, int n, int kMax, int B);
+
+    /**
+     * Helper function to learn on nested subsamples of every size in kGrid (ascending), drawn from the first n rows of data.
+     * If the base learner supports incremental learning, each subsample extends the state of the next smaller one.
+     * Return a vector of size kGrid.size() * B, where element i * B + b is the result of the b-th subsample of
+     * size kGrid[i] (this is also its index in the external storage).
+     */
+    std::vector<std::variant<Result, int>> _learnOnNestedSubsamples(_RunContext &context, const DataSource &data,
+                                                                    long long n, const std::vector<int> &kGrid, int B);
+
+    // Helper function to validate a grid of subsample sizes, return it sorted and without repetitions.
+    static std::vector<int> _normalizeKGrid(std::vector<int> kGrid, long long n, const std::string &caller);
+
     /**
      * Helper function to launch parallel learners to learn on B subsamples.
      * Create a vector of futures to hold potentially not-yet-completed results.
@@ -65,7 +219,8 @@ protected: // Ensure those members are accessible to derived classes (MoVE and R
      * futures has dimension: [numWorkers][numSubsamplesPerWorker].
      */
     std::vector<std::future<std::vector<std::pair<int, std::variant<Result, int>>>>>
-    _launchLearningTasks(const Sample &sample, const std::vector<std::vector<int>> &subsampleIndices, int B);
+    _launchLearningTasks(_RunContext &context, const DataSource &data, long long n,
+                         const std::vector<std::vector<int>> &subsampleIndices, int B);
 
     /**
      * Helper function to collect results from futures and order them by index.
@@ -75,23 +230,79 @@ protected: // Ensure those members are accessible to derived classes (MoVE and R
         std::vector<std::future<std::vector<std::pair<int, std::variant<Result, int>>>>> &futures,
         int B);
 
+    /**
+     * Learning results grouped by duplicates, returned by _groupDuplicateResults.
+     * uniqueIndices[u] is the index (in learningResults) of the first occurrence of the u-th unique candidate,
+     * and counts[u] is the number of learning results that are duplicates of it (including itself).
+     * majorityIndex is the position in uniqueIndices of the majority vote, i.e., the candidate that first
+     * reaches the maximum count when scanning learningResults in order.
+     * majorityIndexByPrefix[b] is the majority vote among the first b + 1 learning results.
+     */
+    struct _DuplicateGroups
+    {
+        std::vector<size_t> uniqueIndices;
+        std::vector<int> counts;
+        size_t majorityIndex = 0;
+        std::vector<size_t> majorityIndexByPrefix;
+    };
+
+    /**
+     * Helper function to group learning results by BaseLearner::isDuplicate.
+     * Used by the majority vote of MoVE and the deduplication in Phase I of ROVE.
+     * The second overload only groups the count results starting at first, the indices in the returned groups
+     * are still indices into learningResults.
+     */
+    _DuplicateGroups _groupDuplicateResults(_RunContext &context,
+                                            const std::vector<std::variant<Result, int>> &learningResults);
+    _DuplicateGroups _groupDuplicateResults(_RunContext &context,
+                                            const std::vector<std::variant<Result, int>> &learningResults,
+                                            size_t first, size_t count);
+
     // Helper function to clean up the subsample results if external storage is enabled.
-    void _cleanupSubsampleResults(const std::vector<std::variant<Result, int>> &learningResults);
+    void _cleanupSubsampleResults(_RunContext &context, const std::vector<std::variant<Result, int>> &learningResults);
 
     /**
-     * Main learning method, run baseLearner on B subsamples of size k by aggregating
-     * the above helper functions.
+     * Main learning method, run baseLearner on B subsamples of size k, drawn from the first n rows of data,
+     * by aggregating the above helper functions.
      * Return a vector of Result or int (index of the result).
      */
-    std::vector<std::variant<Result, int>> _learnOnSubsamples(const Sample &sample, int k, int B);
+    std::vector<std::variant<Result, int>> _learnOnSubsamples(_RunContext &context, const DataSource &data, long long n,
+                                                              int k, int B);
 
 public:
+    /**
+     * Default small problem threshold (in units of work, see setSmallProblemThreshold).
+     * Around this size, starting the worker threads and preparing the storage directory take about as long
+     * as the work itself.
+     */
+    static constexpr double DEFAULT_SMALL_PROBLEM_THRESHOLD = 5e7;
+
+    // Default number of replacements of a subsample that exceeds the learn deadline, see setLearnDeadline
+    static constexpr int DEFAULT_MAX_REPLACEMENTS_PER_SUBSAMPLE = 3;
+
+    /**
+     * Result of a sweep over subsample sizes (MoVE::runSweep and ROVE::runSweep).
+     * For the i-th subsample size kGrid[i], candidates[i] holds the candidates learned on the subsamples of
+     * that size (distinct candidates if the base learner enables deduplication), and selectedByPrefix[i][b]
+     * is the index in candidates[i] of the solution selected when only the first b + 1 subsamples are used.
+     */
+    struct SweepResult
+    {
+        std::vector<int> kGrid;
+        std::vector<std::vector<Result>> candidates;
+        std::vector<std::vector<size_t>> selectedByPrefix;
+
+        // The solution selected for kGrid[kIndex] using the first B subsamples
+        const Result &selected(size_t kIndex, int B) const;
+    };
+
     // Constructor
     _BaseVE(BaseLearner *baseLearner,
             int numParallelLearn = 1,
             std::optional<unsigned int> randomSeed = std::nullopt,
             const std::optional<std::string> &subsampleResultsDir = std::nullopt,
-            bool deleteSubsampleResults = true);
+            bool deleteSubsampleResults = true,
+            StorageLayout storageLayout = StorageLayout::Compressed);
 
     /**
      * Virtual destructor
@@ -102,9 +313,87 @@ public:
      */
     virtual ~_BaseVE();
 
-    // Reset the random seed (currently not used in MoVE and ROVE)
+    /**
+     * Reset the call counter, so that the next call draws the same random subsamples as the first call.
+     * Must not be called concurrently with run.
+     */
     void resetRandomSeed();
 
+    /**
+     * Draw each subsample (for learning, and for the evaluation in ROVE) as a union of random blocks of
+     * blockSize consecutive rows instead of blockSize * (number of blocks) independent rows. Gathers then read
+     * mostly sequential memory, which helps caches and memory-mapped or compressed data sources.
+     * The default blockSize = 1 is uniform row sampling. Must not be called concurrently with run.
+     * Statistical caveat: a block subsample is only distributed like a uniform subsample if the row order
+     * carries no information, i.e., the rows are exchangeable. Data that is sorted, grouped, or collected over
+     * time must be shuffled once beforehand (e.g., with shuffleRows). Even then, rows in the same block always
+     * appear together, so distinct subsamples overlap in whole blocks and are more correlated than uniform
+     * subsamples; keep blockSize small relative to the subsample size k.
+     */
+    void setSubsampleBlockSize(int blockSize);
+    int subsampleBlockSize() const;
+
+    /**
+     * Calls whose work (roughly n * B * k summed over the phases, i.e., rows of the evaluation sample times
+     * rows of all subsamples) is at most threshold run inline: on the calling thread, with in-memory results and
+     * without creating a storage directory. This removes the fixed overhead of threads and storage setup, which
+     * dominates the latency of small problems (n around 10^3 to 10^4). The results are the same as those of a
+     * parallel run. A threshold of 0 disables the inline path. Must not be called concurrently with run.
+     */
+    void setSmallProblemThreshold(double threshold);
+    double smallProblemThreshold() const;
+
+    /**
+     * Number of threads of the pool that runs the jobs of runAsync, i.e., the number of runs in progress at
+     * once (each of them still uses its own parallel learners and evaluators, unless it runs inline).
+     * numWorkers <= 0 (e.g., AUTO_NUM_THREADS) uses availableCpus of autoThreadConfig divided by the number of
+     * threads of a run (numParallelLearn, and numParallelEval for ROVE if larger), at least 1, so that the
+     * runs in progress do not oversubscribe the CPUs. Must be called before the first call to runAsync, throws
+     * std::logic_error afterwards.
+     */
+    void setNumAsyncWorkers(int numWorkers);
+
+    /**
+     * Straggler mitigation: bound each call to learn on a subsample (by MoVE::run and Phase I of ROVE) by
+     * deadline. The base learner receives a CancellationToken that expires at the deadline through
+     * BaseLearner::learnCancellable; if it gives up, the subsample is replaced by a fresh one of the same size,
+     * up to maxReplacementsPerSubsample times, after which the last one is learned without a deadline. B is
+     * unchanged, and the wall time is no longer set by a single pathological subsample.
+     * A deadline of 0 (the default) disables it. A positive deadline requires maxReplacementsPerSubsample >= 1,
+     * otherwise std::invalid_argument is thrown. Learners that do not override learnCancellable are never
+     * abandoned, and sweeps (runSweep) learn nested subsamples without a deadline.
+     * Statistical caveat: replaced subsamples are those the learner finds hard, so the kept subsamples are no
+     * longer uniform; keep the deadline far above the typical learning time so that replacements stay rare.
+     * Results then depend on timing and are not reproducible from the random seed alone.
+     * Must not be called concurrently with run.
+     */
+    void setLearnDeadline(std::chrono::microseconds deadline,
+                          int maxReplacementsPerSubsample = DEFAULT_MAX_REPLACEMENTS_PER_SUBSAMPLE);
+    std::chrono::microseconds learnDeadline() const;
+
+    // Number of subsamples replaced after exceeding the learn deadline, over all calls of this object
+    unsigned long long numReplacedSubsamples() const;
+
+    /**
+     * Directory (run_<id> inside the storage directory) of the last call that stored its subsample results
+     * externally, or std::nullopt if there was none (e.g., no storage directory, or only calls small enough to
+     * run inline). With deleteSubsampleResults = false, this is where the kept results of that call are. With
+     * concurrent calls (e.g., runAsync), "last" is the call that started last. The path of each call that keeps
+     * its results is also logged at the Info level.
+     */
+    std::optional<std::string> lastRunDir() const;
+
+    /**
+     * Write and read the result files of the compressed layout with O_DIRECT (through aligned buffers), so that
+     * external storage bypasses the page cache and does not evict the pages of a memory-mapped dataset.
+     * Falls back to buffered I/O on file systems without O_DIRECT support (e.g., tmpfs before Linux 6.6).
+     * Buffered writes already drop their pages from the cache once written. Off by default: direct reads always
+     * go to the device, which is slower when results are loaded repeatedly on a machine with memory to spare.
+     * The fixed-stride layout is memory-mapped and ignores this setting. Must not be called concurrently with run.
+     */
+    void setDirectStorageIO(bool enabled);
+    bool directStorageIO() const;
+
     // Run the algorithm with default parameters (to be implemented in derived classes)
     virtual Result run(const Sample &sample) = 0;
 };
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include "types.hpp"
+#include "DataSource.hpp"
+#include "CancellationToken.hpp"
+#include "EvaluationMemo.hpp"
 
 #include <vector>
 #include <random>        // For std::mt19937
@@ -24,45 +27,141 @@ private:
     _SubsampleResultIO *_subsampleResultIO;
 
     /**
-     * List of retrieved solutions
+     * List of learned solutions
      * The solution* is expressed either as itself or the index to it.
      */
     const std::vector<std::variant<Result, int>> &_subsampleResultList;
 
+    /**
+     * Indices of the retrieved solutions (the candidates) in _subsampleResultList.
+     * The c-th candidate is _subsampleResultList[_candidateIndices[c]], so the candidates
+     * are a view into _subsampleResultList and are never copied.
+     */
+    std::vector<size_t> _candidateIndices;
+
     // Reference to data
-    const Sample &_sample;
+    const DataSource &_data;
 
     // Number of parallel learners
     int _numParallelLearn;
 
+    // Token of the call (null if it cannot be cancelled), checked between chunks of evaluation
+    const CancellationToken *_cancellation;
+
+    bool _isCancelled() const;
+
+    /**
+     * Evaluation memo shared across runs (null if disabled), see EvaluationMemo.
+     * _memoColumns[c] is the column of the c-th candidate, opened on first use (which also fingerprints _data).
+     */
+    EvaluationMemo *_memo;
+    std::vector<EvaluationMemo::Column *> _memoColumns;
+
+    /**
+     * Positions (in _candidateIndices) of the candidates whose objective values are computed by the current
+     * evaluation. All candidates without a memo, and otherwise those whose values are not all in the memo.
+     * The evaluation helpers below only evaluate these candidates.
+     */
+    std::vector<size_t> _candidatesToEvaluate;
+
+    // Helper function to set _candidatesToEvaluate for an evaluation on rows
+    void _selectCandidatesToEvaluate(const std::vector<int> &rows);
+
+    /**
+     * Helper function to complete an evaluation on rows with the memo: copy the memoized values of the other
+     * candidates into the cache (the dense cache if fullScan, _cachedEvaluation otherwise), and store the values
+     * of _candidatesToEvaluate in the memo.
+     */
+    void _exchangeWithMemo(const std::vector<int> &rows, bool fullScan);
+
+    /**
+     * Helper function to record cache hits (see _LibraryMetrics): of the subsampleRows rows of an evaluation,
+     * all but the evaluatedRows on which the objective was computed were read from the cache.
+     */
+    static void _recordCacheHits(long long subsampleRows, long long evaluatedRows);
+
     /**
      * Cache for storing evaluation results, expressed as a map.
-     * The key is the index of the sample in _sample, and the value stores
+     * The key is the index of the sample in _data, and the value stores
      * the evaluation results of all candidates on that sample, represented as
      * a Vector of size num_candidates.
      * Note that the map structure is required, otherwise we cannot easily associate
-     * the evaluation results with the corresponding sample indices in _sample.
+     * the evaluation results with the corresponding sample indices in _data.
      */
     std::unordered_map<int, RowVector> _cachedEvaluation;
 
     /**
-     * Helper function used to load a specific solution from the storage.
-     * candidateIndex is the index of the solution in the vector _subsampleResultList
+     * Dense cache used by the full-scan mode, of size (numRows, num_candidates).
+     * Row i stores the evaluation results of all candidates on the sample _denseCacheStart + i.
+     * It is row-major, so that summing the rows of a subsample reads contiguous memory.
      */
-    Result _loadCandidate(size_t candidateIndex) const;
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> _denseCache;
+    long long _denseCacheStart = 0;
+
+    /**
+     * The full-scan mode is used when sampleIndexList is a contiguous range of rows and the B subsamples
+     * are expected to cover at least this fraction of it. In that case, all candidates are evaluated on
+     * the whole range in a sequential pass, instead of gathering the selected rows.
+     */
+    static constexpr double FULL_SCAN_MIN_COVERAGE = 0.8;
+
+    // Number of consecutive rows evaluated at once in the full-scan mode (a chunk is copied once per pass)
+    static constexpr long long FULL_SCAN_CHUNK_ROWS = 4096;
+
+    /**
+     * Helper function used to access a specific solution.
+     * candidateIndex is the index of the candidate, i.e., the index in _candidateIndices.
+     * In-memory solutions are returned by reference without copying. Solutions held in
+     * external storage are loaded into buffer, and a reference to buffer is returned.
+     */
+    const Result &_loadCandidate(size_t candidateIndex, Result &buffer) const;
 
     /**
      * Helper function to generate B sets of subsample indices, each of size k.
+     * With blockSize > 1, each set is a union of random blocks of blockSize consecutive entries of sampleIndexList.
      * Returns 1. A vector of vector, that contains B sets of subsample indices.
      *         2. A vector of indices, that contains the unique sample indices to be evaluated on.
      */
     std::pair<std::vector<std::vector<int>>, std::vector<int>>
-    _generateEvaluationSampleIndices(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng);
+    _generateEvaluationSampleIndices(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng,
+                                     int blockSize = 1, bool collectUniqueSamples = true);
+
+    /**
+     * Helper function to decide whether to use the full-scan mode, see FULL_SCAN_MIN_COVERAGE.
+     * The expected coverage of B subsamples of size k drawn from n rows is 1 - (1 - k/n)^B.
+     */
+    static bool _useFullScan(const std::vector<int> &sampleIndexList, int B, int k);
 
     /**
-     * Helper function to evaluate all candidates on given samples.
+     * Helper function used by the full-scan mode.
+     * Evaluate _candidatesToEvaluate on the rows [start, start + numRows) in parallel, each worker streaming through
+     * a contiguous block of rows. The results are written directly into _denseCache.
+     */
+    void _getFullScanEvaluation(long long start, long long numRows);
+
+    /**
+     * Helper function used by the linear-objective mode (BaseLearner::isLinearObjective).
+     * Return the matrix of size (B, d) whose b-th row is the mean of the rows of the b-th subsample, i.e., the
+     * product of the sparse (B, numRows) averaging matrix with the rows. The rows are read once: the contiguous
+     * range [rows.front(), rows.front() + numRows) if contiguous is true, streamed in chunks of FULL_SCAN_CHUNK_ROWS,
+     * and the given (sorted, unique) rows otherwise, gathered together.
+     */
+    Matrix _subsampleMeans(const std::vector<std::vector<int>> &subsampleIndices, const std::vector<int> &rows,
+                           bool contiguous);
+
+    /**
+     * Helper function used by the linear-objective mode.
+     * Return the matrix of size (d, num_candidates) whose c-th column is the c-th candidate.
+     */
+    Matrix _candidateMatrix() const;
+
+    // Helper function to add the cached evaluation results of a sample to sum. Returns false if not cached.
+    bool _addCachedEvaluation(int sampleIndex, RowVector &sum) const;
+
+    /**
+     * Helper function to evaluate _candidatesToEvaluate on given samples.
      * This function is called by the individual worker threads to evaluate their assigned samples.
-     * Returns a Matrix of size (numSamplesAssigned, numCandidates).
+     * Returns a Matrix of size (numSamplesAssigned, numCandidates), the columns of other candidates are unset.
      */
     Matrix _evaluateCandidatesOnSamples(const std::vector<int> &uniqueSampleIndices);
 
@@ -82,17 +181,36 @@ private:
     Matrix _getFinalEvaluationResults(const std::vector<std::vector<int>> &subsampleIndices, int B);
 
 public:
-    // Constructor
+    /**
+     * Constructor
+     * candidateIndices selects the candidates to be evaluated from subsampleResultList.
+     * subsampleResultList, data, cancellation and memo (if not null) must outlive the evaluator.
+     * Once cancellation is requested, _evaluateSubsamples stops early and throws OperationCancelled.
+     * With a memo, objective values of known candidates are read from it, and the computed ones are added.
+     */
     _CachedEvaluator(BaseLearner *baseLearner,
                      _SubsampleResultIO *subsampleResultIO,
                      const std::vector<std::variant<Result, int>> &subsampleResultList,
-                     const Sample &sample,
-                     int numParallelLearn = 1);
+                     std::vector<size_t> candidateIndices,
+                     const DataSource &data,
+                     int numParallelLearn = 1,
+                     const CancellationToken *cancellation = nullptr,
+                     EvaluationMemo *memo = nullptr);
+
+    /**
+     * Whether B subsamples of size k drawn from numRows contiguous rows are expected to cover enough of them for
+     * the full-scan mode (see FULL_SCAN_MIN_COVERAGE), in which case the rows are read sequentially.
+     */
+    static bool _coversMostRows(long long numRows, int B, int k);
 
     /**
      * Main evaluation method. The returned Matrix is a matrix of size (B, num_candidates)
      * Each row corresponds to the evaluation of all candidates on a specific subsample
      * sampleIndexList stores indices of the samples used in the evaluation
+     * If the base learner has a linear objective, the result is the product of the subsample means and the
+     * candidates, and the per-row cache (and the memo) is skipped.
+     * blockSize is the subsample block size (see _BaseVE::setSubsampleBlockSize), 1 for uniform subsamples
      */
-    Matrix _evaluateSubsamples(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng);
+    Matrix _evaluateSubsamples(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng,
+                               int blockSize = 1);
 };
\ No newline at end of file
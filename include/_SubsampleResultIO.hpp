@@ -5,6 +5,10 @@
 #include <string>
 #include <filesystem> // For std::filesystem::path
 #include <optional>   // For std::optional
+#include <mutex>      // For std::mutex (guards the fixed-stride mapping)
+#include <memory>     // For std::unique_ptr (aligned buffers)
+#include <cstdint>    // For std::uint64_t
+#include <atomic>     // For std::atomic (direct I/O flag)
 
 // Forward declaration of BaseLearner
 struct BaseLearner;
@@ -14,36 +18,142 @@ class _SubsampleResultIO
 private:
     BaseLearner *_baseLearner;
 
-    // Optional path to a directory where results are stored
+    // Optional path to a directory where results are stored (the storage root, may be shared)
     std::optional<std::filesystem::path> _resultDir;
 
+    /**
+     * Namespace of this object inside _resultDir, created by _prepareSubsampleResultDir.
+     * Each _SubsampleResultIO object gets its own uniquely named subdirectory, so that many
+     * objects (possibly in different processes) can safely share the same storage root.
+     */
+    std::optional<std::filesystem::path> _runDir;
+
+    // Layout of the results in external storage
+    StorageLayout _layout;
+
+    /**
+     * Whether the result files of the compressed layout are written and read with O_DIRECT (see
+     * _BaseVE::setDirectStorageIO). Cleared by the first open that the file system rejects, the later
+     * files are then buffered.
+     */
+    std::atomic<bool> _directIO;
+
+    // Whether the destructor removes the whole namespace directory, see _setRemoveRunDirOnDestruction
+    bool _removeRunDir = false;
+
+    /**
+     * State of the fixed-stride layout (unused in the compressed layout).
+     * The file holds _numSlots slots. Each slot is a 64-bit header followed by _resultSize doubles.
+     * The header is 0 for an empty slot, and the checksum of the slot (never 0) once written.
+     * The file is created by the first dump, since the result length is only known then.
+     * _mappingMutex guards creating and resizing the mapping, dumps to distinct slots do not synchronize.
+     */
+    std::mutex _mappingMutex;
+    int _numSlots = 0;
+    Eigen::Index _resultSize = -1;
+    int _fd = -1;
+    char *_mapping = nullptr;
+    size_t _mappingBytes = 0;
+
     // Join the directory with the index
     static std::filesystem::path _subsampleResultPath(const std::filesystem::path &dir, int index);
 
+    // Open a result file of the compressed layout, with O_DIRECT if enabled. Sets direct to whether it was used.
+    int _openResultFile(const std::filesystem::path &filePath, int flags, bool &direct);
+
+    /**
+     * Write size bytes of data to a new result file, without leaving the written pages in the page cache.
+     * data must be allocated by _allocateAligned with at least size bytes, its padding may be overwritten.
+     */
+    void _writeResultFile(const std::filesystem::path &filePath, char *data, size_t size);
+
+    // Buffer of at least bytes, aligned for O_DIRECT and padded to a multiple of the alignment
+    using _AlignedBuffer = std::unique_ptr<char, void (*)(void *)>;
+    static _AlignedBuffer _allocateAligned(size_t bytes);
+
+    // Read a whole result file into an aligned buffer, and set size to the size of the file
+    _AlignedBuffer _readResultFile(const std::filesystem::path &filePath, size_t &size);
+
+    // Atomically create a new uniquely named subdirectory of _resultDir
+    static std::filesystem::path _createUniqueRunDir(const std::filesystem::path &rootDir);
+
+    // Helper functions of the fixed-stride layout
+    bool _isFixedStride() const;
+    size_t _slotBytes() const;
+    static std::uint64_t _slotChecksum(const double *data, Eigen::Index size, int index);
+    // Create the file and the mapping (or grow them), must be called with _mappingMutex held
+    void _mapSlotsLocked(int numSlots, Eigen::Index resultSize);
+    void _unmapSlots();
+    // Pointer to the header of slot index, checks the index and that the slot was written
+    const char *_readableSlot(int index);
+    void _dumpFixedStride(const Result &learningResult, int index);
+
 public:
     // Constructor
     _SubsampleResultIO(BaseLearner *baseLearner,
-                       const std::optional<std::string> &subsampleResultsDir);
+                       const std::optional<std::string> &subsampleResultsDir,
+                       StorageLayout layout = StorageLayout::Compressed,
+                       bool directIO = false);
+
+    /**
+     * Destructor, removes the namespace directory if it is empty (i.e., all results have been deleted),
+     * or with all its content if _setRemoveRunDirOnDestruction(true) was called.
+     */
+    ~_SubsampleResultIO();
+
+    // Non-copyable, since the object owns its namespace directory
+    _SubsampleResultIO(const _SubsampleResultIO &) = delete;
+    _SubsampleResultIO &operator=(const _SubsampleResultIO &) = delete;
 
     /**
      * Public IO methods
      * They are not static because they may need access to the baseLearner, which is a private member
      */
-    // Creates the directory.
+    // Creates the storage root (if needed) and the namespace directory of this object.
     void _prepareSubsampleResultDir();
 
-    // Save the learning result to a file.
+    /**
+     * Remove the namespace directory with all results still in it when this object is destroyed.
+     * Used by calls that do not keep their results, so that a call that fails part way (e.g., a learner throws)
+     * leaves nothing behind, whichever results were already dumped.
+     */
+    void _setRemoveRunDirOnDestruction(bool remove);
+
+    /**
+     * Announce that results with indices in [0, numSlots) will be dumped.
+     * Required by the fixed-stride layout to size the file, a no-op in the compressed layout.
+     */
+    void _prepareSlots(int numSlots);
+
+    /**
+     * Save the learning result to a file.
+     * Compressed: the file is written under a temporary name and renamed atomically. Its pages are then dropped
+     *             from the page cache (or bypass it with O_DIRECT), so that the results do not evict the dataset.
+     * Fixed-stride: the result is copied into slot index of the mapped file.
+     */
     void _dumpSubsampleResult(const Result &learningResult, int index);
 
     // Load the learning result from a file (a single solution).
     Result _loadSubsampleResult(int index);
 
+    /**
+     * Load the learning result into buffer, reusing its allocation when possible.
+     * In the fixed-stride layout, this is a copy out of the mapping without any system call.
+     */
+    void _loadSubsampleResult(int index, Result &buffer);
+
     // Delete the learning result files for the given indices.
     void _deleteSubsampleResult(const std::vector<int> &indexList);
 
     // True if results should be saved to/loaded from disk.
     bool isExternalStorateEnabled() const;
 
-    // Get the result directory path.
+    // Get the result directory path (the storage root).
     const std::optional<std::filesystem::path> &getResultDir() const;
+
+    // Get the namespace directory where the results of this object are stored.
+    const std::optional<std::filesystem::path> &getRunDir() const;
+
+    // Get the layout of the results in external storage.
+    StorageLayout getLayout() const;
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <deque>              // For the task queue
+#include <thread>             // For std::thread
+#include <mutex>              // For std::mutex
+#include <condition_variable> // For std::condition_variable
+#include <functional>         // For std::function
+#include <future>             // For std::packaged_task, std::future
+#include <memory>             // For std::shared_ptr
+#include <type_traits>        // For std::invoke_result_t
+#include <stdexcept>          // For std::runtime_error
+
+/**
+ * Fixed-size pool of worker threads that run submitted tasks in submission order.
+ * Used by _BaseVE to run the jobs of runAsync, so that callers can have many runs in flight without
+ * dedicating a thread to each. The threads are started by the constructor.
+ */
+class _ThreadPool
+{
+private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping = false;
+
+    // Loop of each worker: take the next task and run it, until the pool is stopping and the queue is empty
+    void _workerLoop();
+
+public:
+    // Start numWorkers threads (at least 1)
+    explicit _ThreadPool(int numWorkers = 1);
+
+    // Run the tasks that are still queued, then join the threads
+    ~_ThreadPool();
+
+    _ThreadPool(const _ThreadPool &) = delete;
+    _ThreadPool &operator=(const _ThreadPool &) = delete;
+
+    int numWorkers() const;
+
+    /**
+     * Queue func to run on a worker, and return the future of its result.
+     * An exception thrown by func is stored in the future.
+     */
+    template <typename Func>
+    std::future<std::invoke_result_t<Func>> submit(Func func)
+    {
+        // packaged_task is move-only, while std::function must be copyable
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::move(func));
+        std::future<std::invoke_result_t<Func>> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping)
+                throw std::runtime_error("_ThreadPool::submit: The pool is stopping.");
+            _tasks.emplace_back([task]()
+                                { (*task)(); });
+        }
+        _condition.notify_one();
+        return future;
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <random> // For std::mt19937
 #include <Eigen/Dense>
 
 /**
@@ -26,6 +27,20 @@ using RowVector = Eigen::RowVectorXd;
 // Size limit for Eigen variables
 constexpr Eigen::Index MAX_REASONABLE_SIZE = 10000000;
 
+/**
+ * Layout of the subsample results in external storage.
+ * Compressed: one zstd-compressed file per result, serialized by BaseLearner (any result type).
+ * FixedStride: one preallocated, memory-mapped file of B slots of raw doubles. All results must have the
+ *              same length. Intended for fast local storage (e.g., NVMe or tmpfs), where compression is a net loss.
+ * FixedStrideChecked: same as FixedStride, and each slot is verified against a checksum when loaded.
+ */
+enum class StorageLayout
+{
+    Compressed,
+    FixedStride,
+    FixedStrideChecked
+};
+
 // Forward declarations (optional)
 struct _BaseLearner;
 class _SubsampleResultIO;
@@ -36,3 +51,20 @@ class ROVE;
 
 // Helper function to print a Result
 void printResult(const std::string &experimentName, const Result &result);
+
+/**
+ * Randomly permute the rows of sample in place. Used to prepare a dataset for block-contiguous subsampling
+ * (see _BaseVE::setSubsampleBlockSize), which requires the row order to carry no information.
+ */
+void shuffleRows(Sample &sample, unsigned int seed);
+
+/**
+ * Helper function to draw k distinct positions in [0, n) as a union of random blocks.
+ * [0, n) is split into consecutive blocks of blockSize positions (the last one may be shorter). Blocks are
+ * drawn uniformly without replacement, and their positions are appended in order within each block,
+ * until k positions are drawn (only a prefix of the last block is used). All blocks are rotated by a random
+ * offset modulo n, so every position is drawn with probability k / n. The blocks are returned in the order
+ * they were drawn, so every prefix of the result is itself such a draw.
+ * With blockSize = 1, this is a uniformly random sequence of k distinct positions.
+ */
+std::vector<int> _sampleBlockPositions(int n, int k, int blockSize, std::mt19937 &rng);
@@ -0,0 +1,174 @@
+#include "ArrowDataSource.hpp"
+#include "types.hpp"
+
+#include <vector>
+#include <string>
+#include <cstring>   // For std::strcmp
+#include <stdexcept> // For std::invalid_argument, std::out_of_range
+#include <limits>    // For std::numeric_limits
+
+namespace
+{
+    // Check whether any of the rows [first, first + length) of array is null, according to the validity bitmap
+    bool hasNulls(const ArrowArray *array, int64_t first, int64_t length)
+    {
+        if (array->null_count == 0 || array->n_buffers < 1 || array->buffers[0] == nullptr)
+            return false;
+        if (array->null_count > 0 && first == array->offset && length == array->length)
+            return true;
+
+        // null_count is -1 (not computed by the producer), or counts rows of the array outside [first, first + length),
+        // so scan the bitmap (least significant bit first)
+        const uint8_t *validity = static_cast<const uint8_t *>(array->buffers[0]);
+        for (int64_t i = first; i < first + length; ++i)
+        {
+            if (!(validity[i / 8] & (1u << (i % 8))))
+                return true;
+        }
+        return false;
+    }
+}
+
+// Constructor, validate the record batch and record the column buffers
+ArrowDataSource::ArrowDataSource(const ArrowSchema *schema, const ArrowArray *array)
+{
+    if (!schema || !array || !schema->release || !array->release)
+        throw std::invalid_argument("ArrowDataSource constructor: schema and array must be valid (not released)");
+    if (!schema->format || std::strcmp(schema->format, "+s") != 0)
+        throw std::invalid_argument("ArrowDataSource constructor: the record batch must be a struct array (format \"+s\")");
+    if (schema->n_children != array->n_children)
+        throw std::invalid_argument("ArrowDataSource constructor: schema and array have different numbers of children");
+    if (array->n_children == 0)
+        throw std::invalid_argument("ArrowDataSource constructor: the record batch has no columns");
+    if (array->length < 0 || array->length > static_cast<int64_t>(std::numeric_limits<int>::max()))
+        throw std::invalid_argument("ArrowDataSource constructor: invalid number of rows");
+    if (hasNulls(array, array->offset, array->length))
+        throw std::invalid_argument("ArrowDataSource constructor: null rows are not supported");
+
+    _rows = static_cast<Eigen::Index>(array->length);
+    _columns.reserve(array->n_children);
+    for (int64_t j = 0; j < array->n_children; ++j)
+    {
+        const ArrowSchema *childSchema = schema->children ? schema->children[j] : nullptr;
+        const ArrowArray *child = array->children ? array->children[j] : nullptr;
+        if (!childSchema || !child)
+            throw std::invalid_argument("ArrowDataSource constructor: column " + std::to_string(j) + " is missing");
+        std::string name = (childSchema->name ? childSchema->name : "");
+        if (!childSchema->format)
+            throw std::invalid_argument("ArrowDataSource constructor: column \"" + name + "\" has no format");
+
+        Column column;
+        column.name = name;
+        if (std::strcmp(childSchema->format, "g") == 0)
+            column.type = ColumnType::Float64;
+        else if (std::strcmp(childSchema->format, "f") == 0)
+            column.type = ColumnType::Float32;
+        else
+            throw std::invalid_argument("ArrowDataSource constructor: column \"" + name + "\" has unsupported format \"" +
+                                        childSchema->format + "\" (expected float64 \"g\" or float32 \"f\")");
+
+        // The offset of the struct array applies to its children, on top of their own offsets
+        if (child->n_buffers != 2 || child->buffers[1] == nullptr || child->length < array->offset + array->length)
+            throw std::invalid_argument("ArrowDataSource constructor: column \"" + name + "\" is invalid");
+        // Only the rows of the struct array matter, the child may hold more rows around them
+        if (hasNulls(child, child->offset + array->offset, array->length))
+            throw std::invalid_argument("ArrowDataSource constructor: column \"" + name + "\" contains nulls");
+
+        int64_t first = child->offset + array->offset;
+        if (column.type == ColumnType::Float64)
+            column.data = static_cast<const double *>(child->buffers[1]) + first;
+        else
+            column.data = static_cast<const float *>(child->buffers[1]) + first;
+        _columns.push_back(std::move(column));
+    }
+}
+
+Eigen::Index ArrowDataSource::rows() const
+{
+    return _rows;
+}
+
+Eigen::Index ArrowDataSource::cols() const
+{
+    return static_cast<Eigen::Index>(_columns.size());
+}
+
+// Gather column by column, so that each column of out is written sequentially
+void ArrowDataSource::gatherRows(const int *indices, Eigen::Index count, Sample &out) const
+{
+    out.resize(count, cols());
+    for (Eigen::Index j = 0; j < cols(); ++j)
+    {
+        const Column &column = _columns[j];
+        double *outColumn = out.col(j).data();
+        if (column.type == ColumnType::Float64)
+        {
+            const double *data = static_cast<const double *>(column.data);
+            for (Eigen::Index r = 0; r < count; ++r)
+                outColumn[r] = data[indices[r]];
+        }
+        else
+        {
+            const float *data = static_cast<const float *>(column.data);
+            for (Eigen::Index r = 0; r < count; ++r)
+                outColumn[r] = static_cast<double>(data[indices[r]]);
+        }
+    }
+}
+
+void ArrowDataSource::copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const
+{
+    if (start < 0 || count < 0 || start + count > _rows)
+        throw std::out_of_range("ArrowDataSource::copyRows: Rows out of range");
+
+    out.resize(count, cols());
+    for (Eigen::Index j = 0; j < cols(); ++j)
+    {
+        if (_columns[j].type == ColumnType::Float64)
+            out.col(j) = float64Column(j).segment(start, count);
+        else
+            out.col(j) = float32Column(j).segment(start, count).cast<double>();
+    }
+}
+
+void ArrowDataSource::_adviseAccessOnce(bool randomRows) const
+{
+    for (const Column &column : _columns)
+    {
+        size_t valueBytes = column.type == ColumnType::Float64 ? sizeof(double) : sizeof(float);
+        _adviseMappedMemory(column.data, static_cast<size_t>(_rows) * valueBytes, randomRows);
+    }
+}
+
+const ArrowDataSource::Column &ArrowDataSource::_column(Eigen::Index j, ColumnType expectedType) const
+{
+    if (j < 0 || j >= cols())
+        throw std::out_of_range("ArrowDataSource: column index out of range");
+    if (_columns[j].type != expectedType)
+        throw std::invalid_argument("ArrowDataSource: column \"" + _columns[j].name + "\" has a different type");
+    return _columns[j];
+}
+
+const std::string &ArrowDataSource::columnName(Eigen::Index j) const
+{
+    if (j < 0 || j >= cols())
+        throw std::out_of_range("ArrowDataSource::columnName: column index out of range");
+    return _columns[j].name;
+}
+
+ArrowDataSource::ColumnType ArrowDataSource::columnType(Eigen::Index j) const
+{
+    if (j < 0 || j >= cols())
+        throw std::out_of_range("ArrowDataSource::columnType: column index out of range");
+    return _columns[j].type;
+}
+
+Eigen::Map<const Eigen::VectorXd> ArrowDataSource::float64Column(Eigen::Index j) const
+{
+    return Eigen::Map<const Eigen::VectorXd>(static_cast<const double *>(_column(j, ColumnType::Float64).data), _rows);
+}
+
+Eigen::Map<const Eigen::VectorXf> ArrowDataSource::float32Column(Eigen::Index j) const
+{
+    return Eigen::Map<const Eigen::VectorXf>(static_cast<const float *>(_column(j, ColumnType::Float32).data), _rows);
+}
@@ -0,0 +1,46 @@
+#include "CancellationToken.hpp"
+
+#include <string>
+#include <memory> // For std::make_shared
+
+// Constructor
+CancellationToken::CancellationToken()
+    : _state(std::make_shared<_State>())
+{
+}
+
+// Request cancellation
+void CancellationToken::cancel()
+{
+    _state->cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::isCancelled() const
+{
+    for (const _State *state = _state.get(); state; state = state->parent.get())
+    {
+        if (state->cancelled.load(std::memory_order_relaxed))
+            return true;
+        // The clock is only read for tokens with a deadline
+        if (state->deadline != std::chrono::steady_clock::time_point::max() &&
+            std::chrono::steady_clock::now() >= state->deadline)
+            return true;
+    }
+    return false;
+}
+
+// Token that is also cancelled once deadline has passed
+CancellationToken CancellationToken::withDeadline(std::chrono::steady_clock::time_point deadline) const
+{
+    CancellationToken token;
+    token._state->deadline = deadline;
+    token._state->parent = _state;
+    return token;
+}
+
+// Throw OperationCancelled if cancellation was requested
+void CancellationToken::throwIfCancelled(const std::string &caller) const
+{
+    if (isCancelled())
+        throw OperationCancelled(caller + ": The run was cancelled.");
+}
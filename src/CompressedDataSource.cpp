@@ -0,0 +1,427 @@
+#include "CompressedDataSource.hpp"
+#include "types.hpp"
+
+#include <vector>
+#include <string>
+#include <cmath>         // For std::floor, std::abs, std::isfinite
+#include <cstring>       // For std::memcpy
+#include <numeric>       // For std::iota
+#include <algorithm>     // For std::min, std::max
+#include <stdexcept>     // For std::invalid_argument, std::out_of_range
+#include <unordered_map> // For the dictionary
+
+namespace
+{
+    // Bit pattern of a double, used as the dictionary key (so that NaN and -0.0 are kept exactly)
+    std::uint64_t doubleBits(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float bitsToFloat(std::uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::uint32_t floatToBits(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Number of bits needed to store the codes [0, numCodes)
+    int bitWidthFor(std::uint64_t numCodes)
+    {
+        int width = 0;
+        while (width < 64 && (std::uint64_t(1) << width) < numCodes)
+            ++width;
+        return width;
+    }
+
+    // Packed codes of a fixed bit width. One padding word allows reading two words without a bounds check.
+    void writeCode(std::vector<std::uint64_t> &words, int width, Eigen::Index i, std::uint64_t code)
+    {
+        if (width == 0)
+            return;
+        std::uint64_t bitPos = static_cast<std::uint64_t>(i) * width;
+        size_t word = bitPos >> 6;
+        int offset = bitPos & 63;
+        words[word] |= code << offset;
+        if (offset + width > 64)
+            words[word + 1] |= code >> (64 - offset);
+    }
+
+    inline std::uint64_t readCode(const std::uint64_t *words, int width, std::uint64_t mask, Eigen::Index i)
+    {
+        std::uint64_t bitPos = static_cast<std::uint64_t>(i) * width;
+        size_t word = bitPos >> 6;
+        int offset = bitPos & 63;
+        std::uint64_t code = words[word] >> offset;
+        if (offset + width > 64)
+            code |= words[word + 1] << (64 - offset);
+        return code & mask;
+    }
+
+    // IEEE half precision, round to nearest even (overflow to infinity, underflow to subnormals or zero)
+    std::uint16_t floatToHalf(float value)
+    {
+        std::uint32_t bits = floatToBits(value);
+        std::uint32_t sign = (bits >> 16) & 0x8000u;
+        std::uint32_t exponent = (bits >> 23) & 0xFFu;
+        std::uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent == 0xFFu) // Infinity or NaN
+            return static_cast<std::uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+
+        int halfExponent = static_cast<int>(exponent) - 127 + 15;
+        if (halfExponent >= 31) // Overflow
+            return static_cast<std::uint16_t>(sign | 0x7C00u);
+        if (halfExponent <= 0)
+        { // Subnormal or zero
+            if (halfExponent < -10)
+                return static_cast<std::uint16_t>(sign);
+            mantissa |= 0x800000u;
+            int shift = 14 - halfExponent;
+            std::uint32_t halfMantissa = mantissa >> shift;
+            std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            std::uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u)))
+                ++halfMantissa;
+            return static_cast<std::uint16_t>(sign | halfMantissa);
+        }
+
+        std::uint32_t half = sign | (static_cast<std::uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+        std::uint32_t remainder = mantissa & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+            ++half; // May carry into the exponent, which is the correct rounding
+        return static_cast<std::uint16_t>(half);
+    }
+
+    inline float halfToFloat(std::uint16_t half)
+    {
+        std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+        std::uint32_t exponent = (half >> 10) & 0x1Fu;
+        std::uint32_t mantissa = half & 0x3FFu;
+        if (exponent == 0x1Fu) // Infinity or NaN
+            return bitsToFloat(sign | 0x7F800000u | (mantissa << 13));
+        if (exponent == 0)
+        { // Subnormal or zero: mantissa * 2^-24
+            float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            return sign ? -value : value;
+        }
+        return bitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    // bfloat16 is the upper half of a float, round to nearest even
+    std::uint16_t floatToBFloat16(float value)
+    {
+        std::uint32_t bits = floatToBits(value);
+        if ((bits & 0x7F800000u) == 0x7F800000u && (bits & 0x7FFFFFu)) // NaN, keep it a NaN
+            return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+        bits += 0x7FFFu + ((bits >> 16) & 1u);
+        return static_cast<std::uint16_t>(bits >> 16);
+    }
+
+    inline float bfloat16ToFloat(std::uint16_t value)
+    {
+        return bitsToFloat(static_cast<std::uint32_t>(value) << 16);
+    }
+
+    // Statistics of a column, used to choose and build the encodings
+    struct ColumnStats
+    {
+        bool empty = true;
+        bool allInteger = true; // All values are finite integers
+        double min = 0.0;
+        double max = 0.0;
+        double maxAbs = 0.0;                                     // Largest finite absolute value
+        std::unordered_map<std::uint64_t, std::uint32_t> codes; // Distinct values, up to MAX_DICTIONARY_SIZE + 1
+    };
+
+    void addValue(ColumnStats &s, double value, bool trackDistinct)
+    {
+        if (std::isfinite(value))
+            s.maxAbs = std::max(s.maxAbs, std::abs(value));
+        if (s.allInteger && (!std::isfinite(value) || value != std::floor(value)))
+            s.allInteger = false;
+        s.min = s.empty ? value : std::min(s.min, value);
+        s.max = s.empty ? value : std::max(s.max, value);
+        s.empty = false;
+        if (trackDistinct && s.codes.size() <= CompressedDataSource::MAX_DICTIONARY_SIZE)
+            s.codes.emplace(doubleBits(value), static_cast<std::uint32_t>(s.codes.size()));
+    }
+
+    // Read data in blocks of rows, and call visit(start, block) on each
+    template <typename Visit>
+    void forEachBlock(const DataSource &data, Eigen::Index blockRows, Visit visit)
+    {
+        Sample block;
+        for (Eigen::Index start = 0; start < data.rows(); start += blockRows)
+        {
+            Eigen::Index count = std::min(blockRows, data.rows() - start);
+            data.copyRows(start, count, block);
+            visit(start, block);
+        }
+    }
+
+    // Statistics of all columns in one pass over data. Distinct values are only tracked where trackDistinct[j].
+    std::vector<ColumnStats> computeStats(const DataSource &data, Eigen::Index blockRows,
+                                          const std::vector<bool> &trackDistinct)
+    {
+        std::vector<ColumnStats> stats(data.cols());
+        forEachBlock(data, blockRows, [&](Eigen::Index, const Sample &block)
+                     {
+            for (Eigen::Index j = 0; j < block.cols(); ++j)
+                for (Eigen::Index r = 0; r < block.rows(); ++r)
+                    addValue(stats[j], block(r, j), trackDistinct[j]); });
+        return stats;
+    }
+
+    // Bits per value of the integer and dictionary encodings, 64 if they do not apply
+    int bitPackedWidth(const ColumnStats &s)
+    {
+        if (!s.allInteger || s.max - s.min >= 4294967296.0) // At most 32 bits
+            return 64;
+        return bitWidthFor(static_cast<std::uint64_t>(s.max - s.min) + 1);
+    }
+
+    int dictionaryWidth(const ColumnStats &s)
+    {
+        if (s.codes.size() > CompressedDataSource::MAX_DICTIONARY_SIZE)
+            return 64;
+        return bitWidthFor(s.codes.size());
+    }
+
+    // Number of words for count packed codes of the given width, plus one padding word
+    size_t packedWords(Eigen::Index count, int width)
+    {
+        return (static_cast<size_t>(count) * width + 63) / 64 + 1;
+    }
+
+    const char *encodingName(CompressedDataSource::Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case CompressedDataSource::Encoding::Dictionary:
+            return "Dictionary";
+        case CompressedDataSource::Encoding::BitPacked:
+            return "BitPacked";
+        case CompressedDataSource::Encoding::Float16:
+            return "Float16";
+        case CompressedDataSource::Encoding::BFloat16:
+            return "BFloat16";
+        case CompressedDataSource::Encoding::Float64:
+        default:
+            return "Float64";
+        }
+    }
+}
+
+// Constructor: one pass over data for the statistics of the columns, and one pass to encode them
+CompressedDataSource::CompressedDataSource(const DataSource &data, const std::vector<Encoding> &encodings)
+    : _rows(data.rows()), _columns(data.cols())
+{
+    if (static_cast<Eigen::Index>(encodings.size()) != data.cols())
+        throw std::invalid_argument("CompressedDataSource constructor: one encoding per column is required");
+
+    std::vector<bool> trackDistinct(encodings.size());
+    for (size_t j = 0; j < encodings.size(); ++j)
+        trackDistinct[j] = (encodings[j] == Encoding::Dictionary);
+    std::vector<ColumnStats> stats = computeStats(data, ENCODE_BLOCK_ROWS, trackDistinct);
+
+    // Choose the parameters of each column and allocate its storage
+    for (size_t j = 0; j < _columns.size(); ++j)
+    {
+        Column &column = _columns[j];
+        const ColumnStats &s = stats[j];
+        column.encoding = encodings[j];
+        std::string columnName = "column " + std::to_string(j) + " (" + encodingName(column.encoding) + ")";
+        switch (column.encoding)
+        {
+        case Encoding::Float64:
+            column.raw.resize(_rows);
+            break;
+        case Encoding::Dictionary:
+            if (s.codes.size() > MAX_DICTIONARY_SIZE)
+                throw std::invalid_argument("CompressedDataSource constructor: " + columnName + " has more than " +
+                                            std::to_string(MAX_DICTIONARY_SIZE) + " distinct values");
+            column.bitWidth = bitWidthFor(s.codes.size());
+            column.dictionary.resize(s.codes.size());
+            for (const auto &[bits, code] : s.codes)
+                std::memcpy(&column.dictionary[code], &bits, sizeof(double));
+            column.bits.assign(packedWords(_rows, column.bitWidth), 0);
+            break;
+        case Encoding::BitPacked:
+            if (!s.empty && bitPackedWidth(s) == 64)
+                throw std::invalid_argument("CompressedDataSource constructor: " + columnName +
+                                            " must contain integers with a range below 2^32");
+            column.base = s.min;
+            column.bitWidth = s.empty ? 0 : bitPackedWidth(s);
+            column.bits.assign(packedWords(_rows, column.bitWidth), 0);
+            break;
+        case Encoding::Float16:
+        case Encoding::BFloat16:
+            column.scale = s.maxAbs > 0.0 ? s.maxAbs / 32768.0 : 1.0;
+            column.half.resize(_rows);
+            break;
+        default:
+            throw std::invalid_argument("CompressedDataSource constructor: unknown encoding for column " +
+                                        std::to_string(j));
+        }
+    }
+
+    forEachBlock(data, ENCODE_BLOCK_ROWS, [&](Eigen::Index start, const Sample &block)
+                 {
+        for (size_t j = 0; j < _columns.size(); ++j)
+        {
+            Column &column = _columns[j];
+            for (Eigen::Index r = 0; r < block.rows(); ++r)
+            {
+                double value = block(r, j);
+                Eigen::Index i = start + r;
+                switch (column.encoding)
+                {
+                case Encoding::Float64:
+                    column.raw[i] = value;
+                    break;
+                case Encoding::Dictionary:
+                    writeCode(column.bits, column.bitWidth, i, stats[j].codes.at(doubleBits(value)));
+                    break;
+                case Encoding::BitPacked:
+                    writeCode(column.bits, column.bitWidth, i, static_cast<std::uint64_t>(value - column.base));
+                    break;
+                case Encoding::Float16:
+                    column.half[i] = floatToHalf(static_cast<float>(value / column.scale));
+                    break;
+                case Encoding::BFloat16:
+                    column.half[i] = floatToBFloat16(static_cast<float>(value / column.scale));
+                    break;
+                }
+            }
+        } });
+}
+
+CompressedDataSource::CompressedDataSource(const Sample &sample, const std::vector<Encoding> &encodings)
+    : CompressedDataSource(DenseDataSource(sample), encodings)
+{
+}
+
+// Decode the values of column j at the given rows
+void CompressedDataSource::_decodeColumn(Eigen::Index j, const int *rowIndices, Eigen::Index count, double *out) const
+{
+    const Column &column = _columns[j];
+    switch (column.encoding)
+    {
+    case Encoding::Float64:
+        for (Eigen::Index r = 0; r < count; ++r)
+            out[r] = column.raw[rowIndices[r]];
+        break;
+    case Encoding::Dictionary:
+    {
+        std::uint64_t mask = column.bitWidth == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << column.bitWidth) - 1;
+        const double *dictionary = column.dictionary.data();
+        for (Eigen::Index r = 0; r < count; ++r)
+            out[r] = dictionary[readCode(column.bits.data(), column.bitWidth, mask, rowIndices[r])];
+        break;
+    }
+    case Encoding::BitPacked:
+    {
+        std::uint64_t mask = (std::uint64_t(1) << column.bitWidth) - 1;
+        for (Eigen::Index r = 0; r < count; ++r)
+            out[r] = column.base + static_cast<double>(readCode(column.bits.data(), column.bitWidth, mask, rowIndices[r]));
+        break;
+    }
+    case Encoding::Float16:
+        for (Eigen::Index r = 0; r < count; ++r)
+            out[r] = column.scale * static_cast<double>(halfToFloat(column.half[rowIndices[r]]));
+        break;
+    case Encoding::BFloat16:
+        for (Eigen::Index r = 0; r < count; ++r)
+            out[r] = column.scale * static_cast<double>(bfloat16ToFloat(column.half[rowIndices[r]]));
+        break;
+    }
+}
+
+std::vector<CompressedDataSource::Encoding> CompressedDataSource::chooseEncodings(const DataSource &data, bool allowLossy)
+{
+    std::vector<ColumnStats> stats = computeStats(data, ENCODE_BLOCK_ROWS, std::vector<bool>(data.cols(), true));
+    double n = static_cast<double>(data.rows());
+    std::vector<Encoding> encodings;
+    encodings.reserve(stats.size());
+    for (const ColumnStats &s : stats)
+    {
+        // Bytes of each applicable encoding, including the dictionary
+        Encoding best = Encoding::Float64;
+        double bestBytes = 8.0 * n;
+        if (bitPackedWidth(s) < 64 && n * bitPackedWidth(s) / 8.0 < bestBytes)
+        {
+            best = Encoding::BitPacked;
+            bestBytes = n * bitPackedWidth(s) / 8.0;
+        }
+        if (dictionaryWidth(s) < 64 && n * dictionaryWidth(s) / 8.0 + 8.0 * s.codes.size() < bestBytes)
+        {
+            best = Encoding::Dictionary;
+            bestBytes = n * dictionaryWidth(s) / 8.0 + 8.0 * s.codes.size();
+        }
+        if (allowLossy && 2.0 * n < bestBytes)
+            best = Encoding::Float16;
+        encodings.push_back(best);
+    }
+    return encodings;
+}
+
+std::vector<CompressedDataSource::Encoding> CompressedDataSource::chooseEncodings(const Sample &sample, bool allowLossy)
+{
+    return chooseEncodings(DenseDataSource(sample), allowLossy);
+}
+
+Eigen::Index CompressedDataSource::rows() const
+{
+    return _rows;
+}
+
+Eigen::Index CompressedDataSource::cols() const
+{
+    return static_cast<Eigen::Index>(_columns.size());
+}
+
+// Gather column by column, so that each column of out is written sequentially
+void CompressedDataSource::gatherRows(const int *indices, Eigen::Index count, Sample &out) const
+{
+    out.resize(count, cols());
+    for (Eigen::Index j = 0; j < cols(); ++j)
+        _decodeColumn(j, indices, count, out.col(j).data());
+}
+
+void CompressedDataSource::copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const
+{
+    if (start < 0 || count < 0 || start + count > _rows)
+        throw std::out_of_range("CompressedDataSource::copyRows: Rows out of range");
+
+    std::vector<int> indices(count);
+    std::iota(indices.begin(), indices.end(), static_cast<int>(start));
+    gatherRows(indices.data(), count, out);
+}
+
+CompressedDataSource::Encoding CompressedDataSource::encoding(Eigen::Index j) const
+{
+    if (j < 0 || j >= cols())
+        throw std::out_of_range("CompressedDataSource::encoding: column index out of range");
+    return _columns[j].encoding;
+}
+
+size_t CompressedDataSource::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (const Column &column : _columns)
+    {
+        bytes += column.raw.size() * sizeof(double) + column.dictionary.size() * sizeof(double) +
+                 column.bits.size() * sizeof(std::uint64_t) + column.half.size() * sizeof(std::uint16_t);
+    }
+    return bytes;
+}
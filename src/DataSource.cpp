@@ -0,0 +1,103 @@
+#include "DataSource.hpp"
+#include "types.hpp"
+
+#include <vector>
+#include <numeric>   // For std::iota
+#include <stdexcept> // For std::out_of_range
+#include <cstdint>   // For std::uintptr_t
+#include <string>
+#include <fstream>   // For std::ifstream (/proc/self/maps)
+#include <sstream>   // For std::istringstream
+#include <algorithm> // For std::max, std::min
+#include <unistd.h>  // For sysconf
+#include <sys/mman.h> // For madvise
+
+// Copy a block of rows, by default through gatherRows
+void DataSource::copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const
+{
+    if (start < 0 || count < 0 || start + count > rows())
+        throw std::out_of_range("DataSource::copyRows: Rows out of range");
+
+    std::vector<int> indices(count);
+    std::iota(indices.begin(), indices.end(), static_cast<int>(start));
+    gatherRows(indices.data(), count, out);
+}
+
+// Advise the access pattern, once per data source
+void DataSource::adviseAccess(bool randomRows) const
+{
+    if (!_accessAdvised.exchange(true))
+        _adviseAccessOnce(randomRows);
+}
+
+// No hint by default
+void DataSource::_adviseAccessOnce(bool randomRows) const
+{
+    (void)randomRows;
+}
+
+// Advise the file-backed mappings that overlap [data, data + bytes)
+void DataSource::_adviseMappedMemory(const void *data, size_t bytes, bool randomRows)
+{
+    if (!data || bytes == 0)
+        return;
+    std::ifstream maps("/proc/self/maps");
+    if (!maps)
+        return; // Not Linux, no hint
+
+    static const std::uintptr_t pageSize = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data);
+    std::uintptr_t end = begin + bytes;
+    std::string line;
+    while (std::getline(maps, line))
+    {
+        // Each line is "start-end perms offset dev inode [path]", anonymous mappings have inode 0
+        std::istringstream fields(line);
+        std::uintptr_t mapStart = 0, mapEnd = 0;
+        char dash;
+        std::string perms, offset, device;
+        unsigned long long inode = 0;
+        if (!(fields >> std::hex >> mapStart >> dash >> mapEnd >> perms >> offset >> device >> std::dec >> inode))
+            continue;
+        if (inode == 0 || mapEnd <= begin || mapStart >= end)
+            continue;
+
+        // madvise requires a page-aligned start. Mappings are page-aligned, so the range stays in the mapping.
+        std::uintptr_t start = std::max(mapStart, begin / pageSize * pageSize);
+        std::uintptr_t stop = std::min(mapEnd, end);
+        void *pages = reinterpret_cast<void *>(start);
+        if (randomRows)
+            ::madvise(pages, stop - start, MADV_RANDOM);
+        ::madvise(pages, stop - start, MADV_WILLNEED);
+    }
+}
+
+// DenseDataSource constructor
+DenseDataSource::DenseDataSource(const Sample &sample)
+    : _sample(sample)
+{
+}
+
+Eigen::Index DenseDataSource::rows() const
+{
+    return _sample.rows();
+}
+
+Eigen::Index DenseDataSource::cols() const
+{
+    return _sample.cols();
+}
+
+void DenseDataSource::gatherRows(const int *indices, Eigen::Index count, Sample &out) const
+{
+    // Convert indices to Eigen::VectorXi and create a matrix by selecting rows from sample
+    Eigen::Map<const Eigen::VectorXi> indicesMap(indices, count);
+    out = _sample(indicesMap, Eigen::all);
+}
+
+void DenseDataSource::copyRows(Eigen::Index start, Eigen::Index count, Sample &out) const
+{
+    if (start < 0 || count < 0 || start + count > _sample.rows())
+        throw std::out_of_range("DenseDataSource::copyRows: Rows out of range");
+    out = _sample.middleRows(start, count);
+}
@@ -0,0 +1,251 @@
+#include "EvaluationMemo.hpp"
+#include "BaseLearner.hpp"
+#include "types.hpp"
+
+#include <vector>
+#include <string>
+#include <cstring>    // For std::memcpy, std::memcmp, std::strerror
+#include <algorithm>  // For std::min
+#include <cerrno>     // For errno
+#include <atomic>     // For std::atomic_thread_fence
+#include <iomanip>    // For std::setw, std::setfill (hex file names)
+#include <sstream>    // For std::ostringstream
+#include <typeinfo>   // For typeid
+#include <stdexcept>  // For std::invalid_argument, std::runtime_error
+#include <fcntl.h>    // For open
+#include <unistd.h>   // For ftruncate, close
+#include <sys/mman.h> // For mmap, munmap
+#include <sys/stat.h> // For fstat
+
+namespace
+{
+    // Header of a column file, followed by the presence bytes (padded to 8 bytes) and the values
+    struct ColumnHeader
+    {
+        char magic[8];
+        std::uint64_t rows;
+        std::uint64_t fingerprint;
+        std::uint64_t candidateHash;
+    };
+    constexpr char COLUMN_MAGIC[8] = {'V', 'E', 'M', 'E', 'M', 'O', '0', '1'};
+
+    size_t valuesOffset(long long rows)
+    {
+        return (sizeof(ColumnHeader) + static_cast<size_t>(rows) + 7) / 8 * 8;
+    }
+
+    // FNV-1a style mixing of 64-bit words
+    constexpr std::uint64_t HASH_OFFSET = 14695981039346656037ULL;
+    constexpr std::uint64_t HASH_PRIME = 1099511628211ULL;
+
+    void mixWord(std::uint64_t &hash, std::uint64_t word)
+    {
+        // Multiplication only carries bits upwards, so the word is first spread over all bits (the finalizer of
+        // splitmix64). Otherwise doubles that only differ in their high bits (e.g., 0.0 and 2.0) collide.
+        word ^= word >> 30;
+        word *= 0xbf58476d1ce4e5b9ULL;
+        word ^= word >> 27;
+        word *= 0x94d049bb133111ebULL;
+        word ^= word >> 31;
+        hash ^= word;
+        hash *= HASH_PRIME;
+    }
+
+    void mixDoubles(std::uint64_t &hash, const double *data, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, data + i, sizeof(bits));
+            mixWord(hash, bits);
+        }
+    }
+
+    std::string hexName(std::uint64_t value)
+    {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << value;
+        return out.str();
+    }
+}
+
+// Constructor
+EvaluationMemo::EvaluationMemo(const std::string &directory)
+    : _directory(directory)
+{
+    if (directory.empty())
+        throw std::invalid_argument("EvaluationMemo constructor: directory cannot be empty");
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+    if (ec || !std::filesystem::is_directory(_directory))
+        throw std::runtime_error("EvaluationMemo constructor: Failed to create directory: " + directory);
+}
+
+// Destructor
+EvaluationMemo::~EvaluationMemo()
+{
+    for (auto &[name, column] : _columns)
+        ::munmap(column.mapping, column.mappingBytes);
+}
+
+const std::filesystem::path &EvaluationMemo::directory() const
+{
+    return _directory;
+}
+
+// Fingerprint of the content of a dataset
+std::uint64_t EvaluationMemo::fingerprint(const DataSource &data)
+{
+    constexpr Eigen::Index CHUNK_ROWS = 4096;
+    std::uint64_t hash = HASH_OFFSET;
+    mixWord(hash, static_cast<std::uint64_t>(data.rows()));
+    mixWord(hash, static_cast<std::uint64_t>(data.cols()));
+
+    // Row by row, so that the fingerprint does not depend on the chunking
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajorChunk;
+    Sample chunk;
+    for (Eigen::Index start = 0; start < data.rows(); start += CHUNK_ROWS)
+    {
+        data.copyRows(start, std::min(CHUNK_ROWS, data.rows() - start), chunk);
+        rowMajorChunk = chunk;
+        mixDoubles(hash, rowMajorChunk.data(), static_cast<size_t>(rowMajorChunk.size()));
+    }
+    return hash;
+}
+
+// Hash of a candidate and the type of the learner
+std::uint64_t EvaluationMemo::candidateHash(const BaseLearner &baseLearner, const Result &candidate)
+{
+    std::uint64_t hash = HASH_OFFSET;
+    for (const char *name = typeid(baseLearner).name(); *name; ++name)
+        mixWord(hash, static_cast<unsigned char>(*name));
+    mixWord(hash, static_cast<std::uint64_t>(candidate.size()));
+    mixDoubles(hash, candidate.data(), static_cast<size_t>(candidate.size()));
+    return hash;
+}
+
+// Create (or open) the file and map it
+EvaluationMemo::Column EvaluationMemo::_mapColumn(const std::filesystem::path &filePath, std::uint64_t fingerprint,
+                                                  std::uint64_t candidateHash, long long rows)
+{
+    Column column;
+    column.rows = rows;
+    column.mappingBytes = valuesOffset(rows) + static_cast<size_t>(rows) * sizeof(double);
+
+    int fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("EvaluationMemo::column: Failed to open file: " + filePath.string() + ": " +
+                                 std::strerror(errno));
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("EvaluationMemo::column: Failed to stat file: " + filePath.string() + ": " +
+                                 std::strerror(error));
+    }
+
+    // A new file is zero-filled by ftruncate, so no row is present. Processes that create it at once agree on the size.
+    if (static_cast<size_t>(status.st_size) != column.mappingBytes &&
+        (status.st_size != 0 || ::ftruncate(fd, static_cast<off_t>(column.mappingBytes)) != 0))
+    {
+        ::close(fd);
+        throw std::runtime_error("EvaluationMemo::column: File has an unexpected size: " + filePath.string());
+    }
+    void *mapping = ::mmap(nullptr, column.mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd); // The mapping keeps the file open
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("EvaluationMemo::column: Failed to map file: " + filePath.string() + ": " +
+                                 std::strerror(error));
+
+    // Write the header of a new file (the same bytes in every process), check it otherwise
+    ColumnHeader expected;
+    std::memcpy(expected.magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+    expected.rows = static_cast<std::uint64_t>(rows);
+    expected.fingerprint = fingerprint;
+    expected.candidateHash = candidateHash;
+    ColumnHeader *header = static_cast<ColumnHeader *>(mapping);
+    static const char zeros[sizeof(COLUMN_MAGIC)] = {};
+    if (std::memcmp(header->magic, zeros, sizeof(zeros)) == 0)
+    {
+        std::memcpy(header, &expected, sizeof(expected));
+    }
+    else if (std::memcmp(header, &expected, sizeof(expected)) != 0)
+    {
+        ::munmap(mapping, column.mappingBytes);
+        throw std::runtime_error("EvaluationMemo::column: File is not a column of this dataset and candidate: " +
+                                 filePath.string());
+    }
+
+    column.mapping = mapping;
+    column.present = static_cast<unsigned char *>(mapping) + sizeof(ColumnHeader);
+    column.values = reinterpret_cast<double *>(static_cast<char *>(mapping) + valuesOffset(rows));
+    return column;
+}
+
+// The column of a candidate on a dataset
+EvaluationMemo::Column &EvaluationMemo::column(std::uint64_t fingerprint, std::uint64_t candidateHash, long long rows)
+{
+    if (rows <= 0)
+        throw std::invalid_argument("EvaluationMemo::column: rows must be positive");
+    std::string datasetName = hexName(fingerprint);
+    std::string name = datasetName + "/" + hexName(candidateHash);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _columns.find(name);
+    if (it != _columns.end())
+        return it->second;
+
+    std::error_code ec;
+    std::filesystem::create_directories(_directory / datasetName, ec);
+    if (ec)
+        throw std::runtime_error("EvaluationMemo::column: Failed to create directory: " +
+                                 (_directory / datasetName).string());
+    Column column = _mapColumn(_directory / datasetName / (hexName(candidateHash) + ".col"), fingerprint,
+                               candidateHash, rows);
+    return _columns.emplace(name, column).first->second;
+}
+
+// Whether the values of the column on all rows are stored
+bool EvaluationMemo::contains(const Column &column, const std::vector<int> &rows) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int row : rows)
+    {
+        if (row < 0 || row >= column.rows || !column.present[row])
+            return false;
+    }
+    // Pairs with the fence in write, for values written by another process
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+// Copy the values of the column on rows
+void EvaluationMemo::read(const Column &column, const std::vector<int> &rows, double *out) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        int row = rows[i];
+        if (row < 0 || row >= column.rows || !column.present[row])
+            throw std::runtime_error("EvaluationMemo::read: No value stored for row " + std::to_string(row));
+        out[i] = column.values[row];
+    }
+}
+
+// Store values
+void EvaluationMemo::write(Column &column, const std::vector<int> &rows, const double *values)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (rows[i] < 0 || rows[i] >= column.rows)
+            throw std::out_of_range("EvaluationMemo::write: Row out of range: " + std::to_string(rows[i]));
+        column.values[rows[i]] = values[i];
+    }
+    // The values are written before they are marked as present
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int row : rows)
+        column.present[row] = 1;
+}
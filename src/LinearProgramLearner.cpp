@@ -46,6 +46,11 @@ bool LinearProgramLearner::isMinimization() const
     return true;
 }
 
+bool LinearProgramLearner::isLinearObjective() const
+{
+    return true;
+}
+
 bool LinearProgramLearner::enableDeduplication() const
 {
     return true;
@@ -59,6 +64,11 @@ bool LinearProgramLearner::isDuplicate(const Result &result1, const Result &resu
     return (result1 - result2).lpNorm<1>() < tolerance; // Use the L1-distance between two vectors to check for duplicates.
 }
 
+Eigen::Index LinearProgramLearner::findDuplicate(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet) const
+{
+    return findDuplicateByL1Distance(result, uniqueSet, tolerance);
+}
+
 Sample generateLPData(size_t n, const std::vector<double> &meanVector, double noiseStDev, unsigned int seed)
 {
     std::cout << "\nGenerating data (N=" << n << ", meanVector=[" << meanVector[0]
@@ -1,11 +1,117 @@
 #include "LinearRegressionLearner.hpp"
 #include "types.hpp"
+#include "Logger.hpp"
 
 #include <stdexcept>   // For exceptions
 #include <Eigen/Dense> // For Eigen matrix operations
 #include <Eigen/SVD>   // For SVD decomposition
-#include <iostream>    // For std::cerr (error reporting)
+#include <iostream>    // For std::cout (data generation)
 #include <random>      // For C++ random number generation
+#include <array>       // For the tables of fixed-size kernels
+#include <utility>     // For std::integer_sequence
+
+namespace
+{
+    /**
+     * Least-squares solution when X is rank deficient (fewer rows than features), used by learn and learnIncremental.
+     * Compute SVD of X using BDCSVD. Declares a BDCSVD object and factors X into U\Sigma*V^T.
+     * Compute the thin version of U and V, i.e., if n < p, then U is of size (n, p)
+     * and V is of size (p, p). Otherwise, U is of size (n, n) and V is of size (p, n).
+     */
+    Vector solvePseudoInverse(const Matrix &X, const Vector &Y)
+    {
+        VOTE_ENSEMBLE_LOG(LogLevel::Warning, "LinearRegressionLearner::learn: Number of samples: " << X.rows()
+                                                 << " is less than number of features: " << X.cols()
+                                                 << ". Psedo-inverse will be used.");
+        Eigen::BDCSVD<Matrix> svd(X, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+        /**
+         * Solve X * beta = Y using the computed SVD
+         * svd.solve(Y) computes the least-squares solution to the linear system X * beta = Y.
+         */
+        return svd.solve(Y);
+    }
+
+    /**
+     * Fixed-size kernels for P features, used when n >= p. The sample is column-major with the label in the
+     * first column, so the features are mapped in place as an (n, P) matrix without copying.
+     */
+    template <int P>
+    Vector learnFixed(const Sample &sample)
+    {
+        using FeatureMap = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, P>>;
+        FeatureMap X(sample.data() + sample.rows(), sample.rows(), P);
+
+        // Coefficient-based products: each entry is a vectorized dot product of two columns of length n
+        Eigen::Matrix<double, P, P> gram = X.transpose().lazyProduct(X);
+        Eigen::Matrix<double, P, 1> xty = X.transpose().lazyProduct(sample.col(0));
+        return gram.ldlt().solve(xty);
+    }
+
+    template <int P>
+    Vector objectiveFixed(const Result &learningResult, const Sample &sample)
+    {
+        using FeatureMap = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, P>>;
+        FeatureMap X(sample.data() + sample.rows(), sample.rows(), P);
+        // Residuals accumulated column by column (a vectorized axpy per feature, unrolled over P)
+        Vector residuals = sample.col(0);
+        for (int j = 0; j < P; ++j)
+            residuals.noalias() -= learningResult(j) * X.col(j);
+        return residuals.array().square();
+    }
+
+    // Solve the normal equation from the lower triangle of the Gram matrix (used by learnIncremental)
+    template <int P>
+    Vector solveNormalFixed(const Matrix &gram, const Vector &xty)
+    {
+        Eigen::Matrix<double, P, P> fixedGram = gram;
+        return fixedGram.template selfadjointView<Eigen::Lower>().ldlt().solve(Eigen::Matrix<double, P, 1>(xty));
+    }
+
+    /**
+     * Tables of the fixed-size kernels, indexed by p - 1 for p in [1, VOTE_ENSEMBLE_LR_MAX_FIXED_P].
+     * A null entry (or p beyond the table) selects the dynamic-size path.
+     */
+    using LearnKernel = Vector (*)(const Sample &);
+    using ObjectiveKernel = Vector (*)(const Result &, const Sample &);
+    using SolveKernel = Vector (*)(const Matrix &, const Vector &);
+    constexpr int MAX_FIXED_P = VOTE_ENSEMBLE_LR_MAX_FIXED_P;
+
+    template <int... Is>
+    constexpr std::array<LearnKernel, sizeof...(Is)> makeLearnTable(std::integer_sequence<int, Is...>)
+    {
+        return {{&learnFixed<Is + 1>...}};
+    }
+    template <int... Is>
+    constexpr std::array<ObjectiveKernel, sizeof...(Is)> makeObjectiveTable(std::integer_sequence<int, Is...>)
+    {
+        return {{&objectiveFixed<Is + 1>...}};
+    }
+    template <int... Is>
+    constexpr std::array<SolveKernel, sizeof...(Is)> makeSolveTable(std::integer_sequence<int, Is...>)
+    {
+        return {{&solveNormalFixed<Is + 1>...}};
+    }
+
+    constexpr auto learnKernels = makeLearnTable(std::make_integer_sequence<int, MAX_FIXED_P>{});
+    constexpr auto objectiveKernels = makeObjectiveTable(std::make_integer_sequence<int, MAX_FIXED_P>{});
+    constexpr auto solveKernels = makeSolveTable(std::make_integer_sequence<int, MAX_FIXED_P>{});
+
+    template <typename Kernel, size_t N>
+    Kernel fixedKernel(const std::array<Kernel, N> &table, long long p)
+    {
+        return (p >= 1 && p <= static_cast<long long>(N)) ? table[p - 1] : nullptr;
+    }
+
+    // Incremental state of LinearRegressionLearner
+    struct LRIncrementalState : BaseLearner::IncrementalState
+    {
+        long long n = 0;
+        Matrix gram; // X^T X, only the lower triangle is updated
+        Vector xty;  // X^T Y
+        Sample rows; // The rows added so far, only kept while n < p
+    };
+}
 
 // Core learning methods
 Result LinearRegressionLearner::learn(const Sample &sample)
@@ -17,6 +123,17 @@ Result LinearRegressionLearner::learn(const Sample &sample)
 
     long long n = sample.rows();
     long long p = sample.cols() - 1;
+
+    // Fixed-size kernel for small p, dispatched at runtime
+    LearnKernel kernel = fixedKernel(learnKernels, p);
+    if (kernel && n >= p)
+    {
+        Vector beta = kernel(sample);
+        if (!beta.allFinite())
+            throw std::runtime_error("LinearRegressionLearner::learn: Computed beta contains non-finite values.");
+        return beta;
+    }
+
     Vector Y = sample.col(0);       // Labels
     Matrix X = sample.rightCols(p); // Features
 
@@ -24,21 +141,8 @@ Result LinearRegressionLearner::learn(const Sample &sample)
 
     if (n < p)
     {
-        /**
-         * Must be rank deficient, throw a warning and use pseudo-inverse instead.
-         * Compute SVD of X using BDCSVD. Declares a BDCSVD object and factors X into U\Sigma*V^T.
-         * Compute the thin version of U and V, i.e., if n < p, then U is of size (n, p)
-         * and V is of size (p, p). Otherwise, U is of size (n, n) and V is of size (p, n).
-         */
-        std::cerr << "LinearRegressionLearner::learn: Number of samples: " << n << " is less than number of features: "
-                  << p << ". Psedo-inverse will be used." << std::endl;
-        Eigen::BDCSVD<Matrix> svd(X, Eigen::ComputeThinU | Eigen::ComputeThinV);
-
-        /**
-         * Solve X * beta = Y using the computed SVD
-         * svd.solve(Y) computes the least-squares solution to the linear system X * beta = Y.
-         */
-        beta = svd.solve(Y);
+        // Must be rank deficient, throw a warning and use pseudo-inverse instead.
+        beta = solvePseudoInverse(X, Y);
     }
     else
     {
@@ -63,6 +167,10 @@ Vector LinearRegressionLearner::objective(const Result &learningResult, const Sa
     if (learningResult.size() != sample.cols() - 1)
         throw std::invalid_argument("LinearRegressionLearner::objective: Learning result size does not match the number of features.");
 
+    // Fixed-size kernel for small p, dispatched at runtime
+    if (ObjectiveKernel kernel = fixedKernel(objectiveKernels, learningResult.size()))
+        return kernel(learningResult, sample);
+
     // Data extraction (note that learningResult itself is beta)
     Matrix X = sample.rightCols(sample.cols() - 1);
     Vector Y = sample.col(0);
@@ -93,6 +201,66 @@ bool LinearRegressionLearner::isDuplicate(const Result &result1, const Result &r
     return false;
 }
 
+bool LinearRegressionLearner::supportsIncrementalLearning() const
+{
+    return true;
+}
+
+std::unique_ptr<BaseLearner::IncrementalState> LinearRegressionLearner::createIncrementalState() const
+{
+    return std::make_unique<LRIncrementalState>();
+}
+
+Result LinearRegressionLearner::learnIncremental(IncrementalState &state, const Sample &newRows)
+{
+    LRIncrementalState *lrState = dynamic_cast<LRIncrementalState *>(&state);
+    if (!lrState)
+        throw std::invalid_argument("LinearRegressionLearner::learnIncremental: state was not created by this learner");
+    if (newRows.rows() == 0 || newRows.cols() < 2)
+        throw std::invalid_argument("LinearRegressionLearner::learnIncremental: Sample must be nonempty and have at least one feature and one label");
+
+    long long p = newRows.cols() - 1;
+    if (lrState->n == 0)
+    {
+        lrState->gram = Matrix::Zero(p, p);
+        lrState->xty = Vector::Zero(p);
+    }
+    else if (lrState->gram.rows() != p)
+    {
+        throw std::invalid_argument("LinearRegressionLearner::learnIncremental: Number of features does not match the state");
+    }
+
+    // Rank update with the new rows
+    Matrix X = newRows.rightCols(p);
+    lrState->gram.selfadjointView<Eigen::Lower>().rankUpdate(X.transpose());
+    lrState->xty.noalias() += X.transpose() * newRows.col(0);
+    lrState->n += newRows.rows();
+
+    Vector beta(p);
+    if (lrState->n < p)
+    {
+        // Rank deficient, keep the rows for the pseudo-inverse
+        Eigen::Index oldRows = lrState->rows.rows();
+        lrState->rows.conservativeResize(oldRows + newRows.rows(), newRows.cols());
+        lrState->rows.bottomRows(newRows.rows()) = newRows;
+        beta = solvePseudoInverse(lrState->rows.rightCols(p), lrState->rows.col(0));
+    }
+    else
+    {
+        // Normal equation, as in learn
+        lrState->rows.resize(0, 0);
+        if (SolveKernel kernel = fixedKernel(solveKernels, p))
+            beta = kernel(lrState->gram, lrState->xty);
+        else
+            beta = lrState->gram.selfadjointView<Eigen::Lower>().ldlt().solve(lrState->xty);
+    }
+
+    if (!beta.allFinite())
+        throw std::runtime_error("LinearRegressionLearner::learnIncremental: Computed beta contains non-finite values.");
+
+    return beta;
+}
+
 std::pair<Sample, Result> generateLRData(size_t n, int p, double noiseStDev, unsigned int seed)
 {
     std::cout << "\nGenerating data (N=" << n << ", P=" << p
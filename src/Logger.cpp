@@ -0,0 +1,271 @@
+#include "Logger.hpp"
+
+#include <string>
+#include <vector>
+#include <iostream>  // For std::cerr (default sink)
+#include <algorithm> // For std::stable_sort
+#include <cstdlib>   // For std::atexit
+#include <stdexcept> // For std::invalid_argument
+
+namespace
+{
+    std::int64_t steadyNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+const char *logLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Debug:
+        return "DEBUG";
+    case LogLevel::Info:
+        return "INFO";
+    case LogLevel::Warning:
+        return "WARNING";
+    case LogLevel::Error:
+        return "ERROR";
+    case LogLevel::Off:
+    default:
+        return "OFF";
+    }
+}
+
+// Whether a message may be logged now
+bool _LogSite::admit(int burst, std::chrono::nanoseconds interval)
+{
+    /**
+     * The first call after the window has expired starts a new one. Calls racing with it may still be
+     * counted in the old window, so the limit is approximate, which is enough to keep floods out of the log.
+     */
+    std::int64_t now = steadyNanos();
+    std::int64_t start = _windowStart.load(std::memory_order_relaxed);
+    if (now - start >= interval.count() &&
+        _windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        _countInWindow.store(0, std::memory_order_relaxed);
+
+    if (_countInWindow.fetch_add(1, std::memory_order_relaxed) < burst)
+        return true;
+    _suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+std::uint64_t _LogSite::takeSuppressed()
+{
+    return _suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+// Constructor, starts the flush thread
+Logger::Logger()
+    : _sink([](LogLevel level, const std::string &message)
+            { std::cerr << "[" << logLevelName(level) << "] " << message << "\n"; })
+{
+    _flushThread = std::thread(&Logger::_flushLoop, this);
+}
+
+// Destructor, stops the flush thread and writes the remaining messages
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(_flushMutex);
+        _stopping = true;
+    }
+    _flushCondition.notify_all();
+    _flushThread.join();
+    _drain();
+}
+
+// The logger used by the library
+Logger &Logger::global()
+{
+    /**
+     * The logger is never destroyed, so that code running during static destruction (e.g., destructors of
+     * other static objects) can still log. The messages queued at exit are flushed by an atexit handler.
+     */
+    static Logger *logger = []()
+    {
+        Logger *instance = new Logger();
+        std::atexit([]()
+                    { Logger::global().flush(); });
+        return instance;
+    }();
+    return *logger;
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    _level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::level() const
+{
+    return static_cast<LogLevel>(_level.load(std::memory_order_relaxed));
+}
+
+bool Logger::isEnabled(LogLevel level) const
+{
+    return level != LogLevel::Off && static_cast<int>(level) >= _level.load(std::memory_order_relaxed);
+}
+
+void Logger::setRateLimit(int burst, std::chrono::milliseconds interval)
+{
+    if (burst <= 0 || interval.count() <= 0)
+        throw std::invalid_argument("Logger::setRateLimit: burst and interval must be positive");
+    _rateLimitBurst.store(burst, std::memory_order_relaxed);
+    _rateLimitIntervalNanos.store(std::chrono::nanoseconds(interval).count(), std::memory_order_relaxed);
+}
+
+void Logger::setSink(Sink sink)
+{
+    if (!sink)
+        throw std::invalid_argument("Logger::setSink: sink cannot be empty");
+    std::lock_guard<std::mutex> lock(_sinkMutex);
+    _sink = std::move(sink);
+}
+
+void Logger::setFlushInterval(std::chrono::milliseconds interval)
+{
+    if (interval.count() <= 0)
+        throw std::invalid_argument("Logger::setFlushInterval: interval must be positive");
+    {
+        std::lock_guard<std::mutex> lock(_flushMutex);
+        _flushInterval = interval;
+    }
+    _flushCondition.notify_all();
+}
+
+// Whether a message should be formatted and logged
+bool Logger::shouldLog(LogLevel level, _LogSite &site)
+{
+    return isEnabled(level) &&
+           site.admit(_rateLimitBurst.load(std::memory_order_relaxed),
+                      std::chrono::nanoseconds(_rateLimitIntervalNanos.load(std::memory_order_relaxed)));
+}
+
+// Ring buffer of the calling thread, registered on first use
+Logger::_ThreadBuffer &Logger::_localBuffer()
+{
+    // The buffer is shared with _buffers, so messages left by a thread that has exited are still flushed
+    thread_local const Logger *owner = nullptr;
+    thread_local std::shared_ptr<_ThreadBuffer> buffer;
+    if (owner != this)
+    {
+        buffer = std::make_shared<_ThreadBuffer>();
+        owner = this;
+        std::lock_guard<std::mutex> lock(_buffersMutex);
+        _buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Queue a message
+void Logger::log(LogLevel level, _LogSite &site, std::string message)
+{
+    std::uint64_t suppressed = site.takeSuppressed();
+    if (suppressed > 0)
+        message += " (" + std::to_string(suppressed) + " similar messages were suppressed)";
+
+    // Single producer: only this thread writes head, so the slot at head is free once tail has passed it
+    _ThreadBuffer &buffer = _localBuffer();
+    size_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= BUFFER_CAPACITY)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record &record = buffer.records[head % BUFFER_CAPACITY];
+    record.time = steadyNanos();
+    record.level = level;
+    record.message = std::move(message);
+    buffer.head.store(head + 1, std::memory_order_release);
+
+    if (level >= LogLevel::Error)
+    { // Errors are written at once
+        {
+            std::lock_guard<std::mutex> lock(_flushMutex);
+            _flushRequested = true;
+        }
+        _flushCondition.notify_all();
+    }
+}
+
+// Write all queued messages to the sink
+void Logger::flush()
+{
+    _drain();
+}
+
+// Loop of the flush thread
+void Logger::_flushLoop()
+{
+    std::unique_lock<std::mutex> lock(_flushMutex);
+    while (!_stopping)
+    {
+        _flushCondition.wait_for(lock, _flushInterval, [this]()
+                                 { return _stopping || _flushRequested; });
+        _flushRequested = false;
+        lock.unlock();
+        _drain();
+        lock.lock();
+    }
+}
+
+// Take the queued messages of all threads and write them to the sink
+void Logger::_drain()
+{
+    // _sinkMutex also makes this the only consumer of the buffers
+    std::lock_guard<std::mutex> sinkLock(_sinkMutex);
+
+    std::vector<std::shared_ptr<_ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(_buffersMutex);
+        buffers = _buffers;
+    }
+
+    std::vector<Record> records;
+    for (const auto &buffer : buffers)
+    {
+        size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        size_t head = buffer->head.load(std::memory_order_acquire);
+        for (size_t i = tail; i < head; ++i)
+            records.push_back(std::move(buffer->records[i % BUFFER_CAPACITY]));
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    // Forget the buffers of threads that have exited (only _buffers and the copy above hold them), once empty
+    {
+        std::lock_guard<std::mutex> lock(_buffersMutex);
+        _buffers.erase(std::remove_if(_buffers.begin(), _buffers.end(),
+                                      [](const std::shared_ptr<_ThreadBuffer> &buffer)
+                                      {
+                                          return buffer.use_count() == 2 &&
+                                                 buffer->head.load(std::memory_order_acquire) ==
+                                                     buffer->tail.load(std::memory_order_relaxed);
+                                      }),
+                       _buffers.end());
+    }
+
+    std::uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (records.empty() && dropped == 0)
+        return;
+
+    // Order the messages of all threads by time, and collapse identical consecutive messages
+    std::stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b)
+                     { return a.time < b.time; });
+    for (size_t i = 0; i < records.size();)
+    {
+        size_t j = i + 1;
+        while (j < records.size() && records[j].level == records[i].level && records[j].message == records[i].message)
+            ++j;
+        if (j - i > 1)
+            records[i].message += " (repeated " + std::to_string(j - i) + " times)";
+        _sink(records[i].level, records[i].message);
+        i = j;
+    }
+    if (dropped > 0)
+        _sink(LogLevel::Warning, "Logger: " + std::to_string(dropped) + " messages were dropped because a thread's buffer was full.");
+}
@@ -0,0 +1,344 @@
+#include "Metrics.hpp"
+#include "Logger.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>    // For std::ostringstream
+#include <fstream>    // For std::ofstream
+#include <filesystem> // For std::filesystem::rename
+#include <iomanip>    // For std::setprecision
+#include <limits>     // For std::numeric_limits
+#include <cmath>      // For std::isnan, std::isinf
+#include <algorithm>  // For std::lower_bound, std::is_sorted
+#include <stdexcept>  // For std::invalid_argument, std::runtime_error
+#include <unistd.h>   // For getpid
+
+void Counter::add(std::uint64_t amount)
+{
+    _value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+std::uint64_t Counter::value() const
+{
+    return _value.load(std::memory_order_relaxed);
+}
+
+void Gauge::add(std::int64_t amount)
+{
+    _value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Gauge::set(std::int64_t value)
+{
+    _value.store(value, std::memory_order_relaxed);
+}
+
+std::int64_t Gauge::value() const
+{
+    return _value.load(std::memory_order_relaxed);
+}
+
+Gauge::Scope::Scope(Gauge &gauge) : _gauge(gauge)
+{
+    _gauge.add(1);
+}
+
+Gauge::Scope::~Scope()
+{
+    _gauge.add(-1);
+}
+
+// Constructor
+Histogram::Histogram(std::vector<double> upperBounds)
+    : _upperBounds(std::move(upperBounds)),
+      _bucketCounts(new std::atomic<std::uint64_t>[_upperBounds.size() + 1])
+{
+    if (!std::is_sorted(_upperBounds.begin(), _upperBounds.end()))
+        throw std::invalid_argument("Histogram constructor: upperBounds must be ascending");
+    for (size_t i = 0; i <= _upperBounds.size(); ++i)
+        _bucketCounts[i].store(0, std::memory_order_relaxed);
+}
+
+// Bounds from 1 microsecond to 10 seconds
+std::vector<double> Histogram::defaultLatencyBounds()
+{
+    return {1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+            1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+}
+
+void Histogram::observe(double value)
+{
+    // The first bucket whose upper bound is >= value (buckets are "less than or equal")
+    size_t bucket = std::lower_bound(_upperBounds.begin(), _upperBounds.end(), value) - _upperBounds.begin();
+    _bucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+
+    // std::atomic<double> has no fetch_add before C++20
+    double sum = _sum.load(std::memory_order_relaxed);
+    while (!_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+const std::vector<double> &Histogram::upperBounds() const
+{
+    return _upperBounds;
+}
+
+std::vector<std::uint64_t> Histogram::cumulativeCounts() const
+{
+    std::vector<std::uint64_t> counts(_upperBounds.size() + 1);
+    std::uint64_t total = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        total += _bucketCounts[i].load(std::memory_order_relaxed);
+        counts[i] = total;
+    }
+    return counts;
+}
+
+std::uint64_t Histogram::count() const
+{
+    return _count.load(std::memory_order_relaxed);
+}
+
+double Histogram::sum() const
+{
+    return _sum.load(std::memory_order_relaxed);
+}
+
+Histogram::Timer::Timer(Histogram &histogram)
+    : _histogram(histogram), _start(std::chrono::steady_clock::now())
+{
+}
+
+Histogram::Timer::~Timer()
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _start;
+    _histogram.observe(elapsed.count());
+}
+
+// The registry used by the library
+MetricsRegistry &MetricsRegistry::global()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Entry &MetricsRegistry::_register(const std::string &name, const std::string &help, Type type)
+{
+    // Caller holds _mutex
+    auto [it, inserted] = _entries.try_emplace(name);
+    Entry &entry = it->second;
+    if (inserted)
+    {
+        entry.type = type;
+        entry.help = help;
+    }
+    else if (entry.type != type)
+    {
+        throw std::invalid_argument("MetricsRegistry: Metric " + name + " is already registered with another type");
+    }
+    return entry;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _register(name, help, Type::Counter);
+    if (!entry.counter)
+        entry.counter = std::make_unique<Counter>();
+    return *entry.counter;
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _register(name, help, Type::Gauge);
+    if (!entry.gauge)
+        entry.gauge = std::make_unique<Gauge>();
+    return *entry.gauge;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, std::vector<double> upperBounds)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _register(name, help, Type::Histogram);
+    if (!entry.histogram)
+        entry.histogram = std::make_unique<Histogram>(std::move(upperBounds));
+    return *entry.histogram;
+}
+
+// Shortest decimal representation of value that reads back exactly, e.g., "2.5e-06" rather than 17 digits
+static std::string formatDouble(double value)
+{
+    if (std::isnan(value))
+        return "NaN";
+    if (std::isinf(value))
+        return value > 0 ? "+Inf" : "-Inf";
+
+    std::ostringstream out;
+    for (int precision = 6; precision < std::numeric_limits<double>::max_digits10; ++precision)
+    {
+        out.str("");
+        out << std::setprecision(precision) << value;
+        if (std::stod(out.str()) == value)
+            return out.str();
+    }
+    out.str("");
+    out << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    return out.str();
+}
+
+// Snapshot of all metrics in the Prometheus text exposition format
+std::string MetricsRegistry::toText() const
+{
+    std::ostringstream out;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &[name, entry] : _entries)
+    {
+        out << "# HELP " << name << " " << entry.help << "\n";
+        switch (entry.type)
+        {
+        case Type::Counter:
+            out << "# TYPE " << name << " counter\n";
+            out << name << " " << entry.counter->value() << "\n";
+            break;
+        case Type::Gauge:
+            out << "# TYPE " << name << " gauge\n";
+            out << name << " " << entry.gauge->value() << "\n";
+            break;
+        case Type::Histogram:
+        {
+            out << "# TYPE " << name << " histogram\n";
+            const std::vector<double> &bounds = entry.histogram->upperBounds();
+            std::vector<std::uint64_t> counts = entry.histogram->cumulativeCounts();
+            for (size_t i = 0; i < bounds.size(); ++i)
+                out << name << "_bucket{le=\"" << formatDouble(bounds[i]) << "\"} " << counts[i] << "\n";
+            // _count is taken from the same snapshot as the buckets, so that it equals the +Inf bucket
+            out << name << "_bucket{le=\"+Inf\"} " << counts.back() << "\n";
+            out << name << "_sum " << formatDouble(entry.histogram->sum()) << "\n";
+            out << name << "_count " << counts.back() << "\n";
+            break;
+        }
+        }
+    }
+    return out.str();
+}
+
+// Write toText() to path atomically
+void MetricsRegistry::writeTextfile(const std::string &path) const
+{
+    /**
+     * The temporary name does not end in .prom, so the textfile collector never reads it. The process id and
+     * a counter keep concurrent writers (in this or another process) from sharing a temporary file.
+     */
+    static std::atomic<unsigned long long> counter{0};
+    std::string tempPath = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter.fetch_add(1));
+    {
+        std::ofstream outFile(tempPath, std::ios::trunc);
+        if (!outFile)
+            throw std::runtime_error("MetricsRegistry::writeTextfile: Failed to open file for writing: " + tempPath);
+        outFile << toText();
+        outFile.close();
+        if (!outFile)
+            throw std::runtime_error("MetricsRegistry::writeTextfile: Failed to write file: " + tempPath);
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        throw std::runtime_error("MetricsRegistry::writeTextfile: Failed to rename file: " + tempPath + " to " + path);
+    }
+}
+
+// Constructor, starts the export thread
+MetricsTextfileExporter::MetricsTextfileExporter(std::string path, std::chrono::milliseconds interval,
+                                                 MetricsRegistry &registry)
+    : _path(std::move(path)), _interval(interval), _registry(registry)
+{
+    if (_path.empty())
+        throw std::invalid_argument("MetricsTextfileExporter constructor: path cannot be empty");
+    if (_interval.count() <= 0)
+        throw std::invalid_argument("MetricsTextfileExporter constructor: interval must be positive");
+    _thread = std::thread(&MetricsTextfileExporter::_exportLoop, this);
+}
+
+// Destructor, stops the export thread and writes a final snapshot
+MetricsTextfileExporter::~MetricsTextfileExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+    try
+    {
+        exportNow();
+    }
+    catch (const std::exception &e)
+    {
+        VOTE_ENSEMBLE_LOG(LogLevel::Error, "MetricsTextfileExporter: " << e.what());
+    }
+}
+
+void MetricsTextfileExporter::exportNow()
+{
+    _registry.writeTextfile(_path);
+}
+
+// Loop of the export thread
+void MetricsTextfileExporter::_exportLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_condition.wait_for(lock, _interval, [this]()
+                                { return _stopping; }))
+    {
+        lock.unlock();
+        try
+        {
+            exportNow();
+        }
+        catch (const std::exception &e)
+        {
+            VOTE_ENSEMBLE_LOG(LogLevel::Error, "MetricsTextfileExporter: " << e.what());
+        }
+        lock.lock();
+    }
+}
+
+// The metrics recorded by the library
+_LibraryMetrics &_LibraryMetrics::get()
+{
+    static _LibraryMetrics metrics{
+        MetricsRegistry::global().counter("vote_ensemble_subsamples_learned_total",
+                                          "Calls to BaseLearner::learn and learnIncremental."),
+        MetricsRegistry::global().counter("vote_ensemble_replaced_subsamples_total",
+                                          "Subsamples abandoned after exceeding the learn deadline and replaced."),
+        MetricsRegistry::global().histogram("vote_ensemble_learn_seconds",
+                                            "Latency of calls to BaseLearner::learn and learnIncremental in seconds."),
+        MetricsRegistry::global().histogram("vote_ensemble_objective_seconds",
+                                            "Latency of calls to BaseLearner::objective in seconds."),
+        MetricsRegistry::global().counter("vote_ensemble_evaluation_rows_total",
+                                          "Rows on which the candidates were evaluated."),
+        MetricsRegistry::global().counter("vote_ensemble_evaluation_cache_hits_total",
+                                          "Subsample rows whose objective values were read from the evaluation cache."),
+        MetricsRegistry::global().counter("vote_ensemble_evaluation_memo_hits_total",
+                                          "Candidates whose objective values on the evaluated rows were read from the evaluation memo."),
+        MetricsRegistry::global().counter("vote_ensemble_storage_written_bytes_total",
+                                          "Bytes of learning results written to external storage."),
+        MetricsRegistry::global().counter("vote_ensemble_storage_read_bytes_total",
+                                          "Bytes of learning results read from external storage."),
+        MetricsRegistry::global().gauge("vote_ensemble_async_queue_depth",
+                                        "runAsync jobs waiting for a pool thread."),
+        MetricsRegistry::global().gauge("vote_ensemble_async_running_jobs",
+                                        "runAsync jobs in progress."),
+        MetricsRegistry::global().gauge("vote_ensemble_active_workers",
+                                        "Learning and evaluation workers in progress."),
+    };
+    return metrics;
+}
@@ -2,6 +2,8 @@
 #include "_BaseVE.hpp"
 #include "BaseLearner.hpp"
 #include "_SubsampleResultIO.hpp"
+#include "DataSource.hpp"
+#include "Logger.hpp"
 #include "types.hpp"
 
 #include <vector>
@@ -9,23 +11,29 @@
 #include <optional>  // For std::optional
 #include <variant>   // For std::variant
 #include <utility>   // For std::pair
-#include <iostream>  // For std::cerr
 #include <stdexcept> // For std::invalid_argument, std::runtime_error
 #include <algorithm> // For std::min, std::max
-#include <limits>    // For numeric_limits
+#include <numeric>   // For std::accumulate
 
 // Constructor
 MoVE::MoVE(BaseLearner *baseLearner,
            int numParallelLearn,
            std::optional<unsigned int> randomSeed,
            const std::optional<std::string> &subsampleResultsDir,
-           bool deleteSubsampleResults)
-    : _BaseVE(baseLearner, numParallelLearn, randomSeed, subsampleResultsDir, deleteSubsampleResults)
+           bool deleteSubsampleResults,
+           StorageLayout storageLayout)
+    : _BaseVE(baseLearner, numParallelLearn, randomSeed, subsampleResultsDir, deleteSubsampleResults, storageLayout)
 {
     if (!_baseLearner || !_baseLearner->enableDeduplication())
         throw std::invalid_argument("MoVE constructor: baseLearner cannot be null and must enable deduplication.");
 }
 
+// Destructor, the jobs of runAsync call _run on this object
+MoVE::~MoVE()
+{
+    _stopAsyncPool();
+}
+
 // Helper function to finalize the choice for B and k
 std::pair<int, int> MoVE::_chooseParameters(long long n, int B_in, std::optional<int> k_in) const
 {
@@ -40,7 +48,7 @@ std::pair<int, int> MoVE::_chooseParameters(long long n, int B_in, std::optional
         }
         if (kVal > n)
         { // print a warning, do not need to throw
-            std::cerr << "MoVE::_chooseParameters: Provided k is larger than sample size n. Using n instead." << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Warning, "MoVE::_chooseParameters: Provided k is larger than sample size n. Using n instead.");
             kVal = static_cast<int>(n);
             BVal = 1;
         }
@@ -53,87 +61,68 @@ std::pair<int, int> MoVE::_chooseParameters(long long n, int B_in, std::optional
     return {BVal, kVal};
 }
 
-// Helper function to implement the majority voting process in MoVE
-size_t MoVE::_performMajorityVoting(const std::vector<std::variant<Result, int>> &learningResults)
+// run function with all parameters specified
+Result MoVE::run(const Sample &sample, int B, std::optional<int> k)
 {
-    /**
-     * uniqueResultIndexCounts is a vector of pairs (index, count)
-     * maxIndex stores the index of the most frequent candidate (in learningResults)
-     */
-    std::vector<std::pair<size_t, int>> uniqueResultIndexCounts;
-    size_t maxIndex = 0;
-    int maxCount = 0;
-
-    for (size_t i = 0; i < learningResults.size(); ++i)
-    {
-        Result candidate1 = _loadResultIfNeeded(learningResults[i]);
-        if (candidate1.size() == 0)
-        { // Note that Result is essentially a vector
-            throw std::runtime_error("MoVE::_performMajorityVoting: Empty candidate result at index " + std::to_string(i));
-        }
-
-        size_t foundAtIndex = std::numeric_limits<size_t>::max(); // To help find the index of the candidate
-        for (size_t j = 0; j < uniqueResultIndexCounts.size(); ++j)
-        { // Check if candidate1 agrees with any existing candidate
-            Result candidate2 = _loadResultIfNeeded(learningResults[uniqueResultIndexCounts[j].first]);
-            if (_baseLearner->isDuplicate(candidate1, candidate2))
-            {
-                foundAtIndex = j; // Found a match
-                break;
-            }
-        }
+    DenseDataSource data(sample);
+    return run(data, B, k);
+}
 
-        int currentCount = 0; // To help check whether the current candidate becomes the most frequent
-        if (foundAtIndex != std::numeric_limits<size_t>::max())
-        { // Found a match, increment the count
-            uniqueResultIndexCounts[foundAtIndex].second++;
-            currentCount = uniqueResultIndexCounts[foundAtIndex].second;
-        }
-        else
-        { // No match found, add a new candidate
-            uniqueResultIndexCounts.emplace_back(i, 1);
-            currentCount = 1;
-            foundAtIndex = uniqueResultIndexCounts.size() - 1; // The index of the new candidate
-        }
+// run function on a DataSource
+Result MoVE::run(const DataSource &data, int B, std::optional<int> k)
+{
+    return _run(data, B, k, nullptr);
+}
 
-        // Update the most frequent candidate
-        if (currentCount > maxCount)
-        {
-            maxCount = currentCount;
-            maxIndex = uniqueResultIndexCounts[foundAtIndex].first;
-        }
-    } // End of the loop over learningResults
+// Start run on the async pool
+std::future<Result> MoVE::runAsync(Sample sample, int B, std::optional<int> k, CancellationToken cancellation)
+{
+    return _submitAsync([this, sample = std::move(sample), B, k, cancellation]()
+                        {
+        cancellation.throwIfCancelled("MoVE::runAsync");
+        DenseDataSource data(sample);
+        return _run(data, B, k, &cancellation); });
+}
 
-    return maxIndex;
+std::future<Result> MoVE::runAsync(const DataSource &data, int B, std::optional<int> k, CancellationToken cancellation)
+{
+    return _submitAsync([this, &data, B, k, cancellation]()
+                        {
+        cancellation.throwIfCancelled("MoVE::runAsync");
+        return _run(data, B, k, &cancellation); });
 }
 
-// run function with all parameters specified
-Result MoVE::run(const Sample &sample, int B, std::optional<int> k)
+// Implementation of run
+Result MoVE::_run(const DataSource &data, int B, std::optional<int> k, const CancellationToken *cancellation)
 {
-    // Validate input and determine arameters
-    long long n = sample.rows();
+    // Validate input and determine parameters
+    long long n = data.rows();
     if (n == 0)
         throw std::invalid_argument("MoVE::run: Sample size n must be greater than 0.");
     if (B <= 0)
         throw std::invalid_argument("MoVE::run: Number of subsamples B must be positive.");
     auto [BVal, kVal] = _chooseParameters(n, B, k);
+    _RunContext context = _beginRun(static_cast<double>(n) * BVal * kVal, cancellation);
+    _adviseDataAccess(context, data);
 
     /**
      * Learn on subsamples and retrieve solutions as a vector
      * learningResults is a vector of size B, each element is either a Result or an int (index)
      */
-    std::vector<std::variant<Result, int>> learningResults = _learnOnSubsamples(sample, kVal, BVal);
+    std::vector<std::variant<Result, int>> learningResults = _learnOnSubsamples(context, data, n, kVal, BVal);
     if (learningResults.empty())
         throw std::runtime_error("MoVE::run: No learning results obtained.");
 
     // Perform majority voting to find the most frequently returned solution
-    size_t maxIndex = _performMajorityVoting(learningResults);
-    Result finalResult = _loadResultIfNeeded(learningResults[maxIndex]);
+    _DuplicateGroups groups = _groupDuplicateResults(context, learningResults);
+    size_t maxIndex = groups.uniqueIndices[groups.majorityIndex];
+    Result buffer;
+    Result finalResult = _loadResultIfNeeded(context, learningResults[maxIndex], buffer);
     if (finalResult.size() == 0)
         throw std::runtime_error("MoVE::run: The result of majority voting is empty.");
 
     // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
-    _cleanupSubsampleResults(learningResults);
+    _cleanupSubsampleResults(context, learningResults);
 
     return finalResult;
 }
@@ -142,4 +131,48 @@ Result MoVE::run(const Sample &sample, int B, std::optional<int> k)
 Result MoVE::run(const Sample &sample)
 {
     return run(sample, 200, std::nullopt);
-}
\ No newline at end of file
+}
+
+// Run MoVE for every subsample size in kGrid with nested subsamples
+MoVE::SweepResult MoVE::runSweep(const Sample &sample, const std::vector<int> &kGrid, int B)
+{
+    DenseDataSource data(sample);
+    return runSweep(data, kGrid, B);
+}
+
+MoVE::SweepResult MoVE::runSweep(const DataSource &data, const std::vector<int> &kGrid, int B)
+{
+    long long n = data.rows();
+    if (n == 0)
+        throw std::invalid_argument("MoVE::runSweep: Sample size n must be greater than 0.");
+    if (B <= 0)
+        throw std::invalid_argument("MoVE::runSweep: Number of subsamples B must be positive.");
+
+    SweepResult sweep;
+    sweep.kGrid = _normalizeKGrid(kGrid, n, "MoVE::runSweep");
+    _RunContext context = _beginRun(static_cast<double>(n) * B *
+                                    std::accumulate(sweep.kGrid.begin(), sweep.kGrid.end(), 0LL));
+    _adviseDataAccess(context, data);
+
+    // Learning results of size kGrid.size() * B, the results of the i-th size start at i * B
+    std::vector<std::variant<Result, int>> learningResults = _learnOnNestedSubsamples(context, data, n, sweep.kGrid, B);
+
+    // Majority voting for each size, the prefixes are tracked by the grouping
+    Result buffer;
+    for (size_t i = 0; i < sweep.kGrid.size(); ++i)
+    {
+        _DuplicateGroups groups = _groupDuplicateResults(context, learningResults, i * B, B);
+
+        std::vector<Result> candidates;
+        candidates.reserve(groups.uniqueIndices.size());
+        for (size_t index : groups.uniqueIndices)
+            candidates.push_back(_loadResultIfNeeded(context, learningResults[index], buffer));
+        sweep.candidates.push_back(std::move(candidates));
+        sweep.selectedByPrefix.push_back(std::move(groups.majorityIndexByPrefix));
+    }
+
+    // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
+    _cleanupSubsampleResults(context, learningResults);
+
+    return sweep;
+}
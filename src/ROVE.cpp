@@ -3,6 +3,9 @@
 #include "BaseLearner.hpp"
 #include "_CachedEvaluator.hpp"
 #include "_SubsampleResultIO.hpp"
+#include "ThreadConfig.hpp"
+#include "DataSource.hpp"
+#include "Logger.hpp"
 #include "types.hpp"
 
 #include <vector>
@@ -10,11 +13,10 @@
 #include <stdexcept> // For std::invalid_argument, std::runtime_error
 #include <optional>  // For std::optional
 #include <variant>   // For std::variant
-#include <numeric>   // For std::iota
+#include <numeric>   // For std::iota, std::accumulate
 #include <algorithm> // For std::min, std::max, std::shuffle
 #include <cmath>     // For std::floor, std::abs, std::pow? (No, Eigen handles math)
 #include <limits>    // For std::numeric_limits
-#include <iostream>  // For potential std::cerr
 
 // Constructor
 ROVE::ROVE(BaseLearner *baseLearner,
@@ -23,15 +25,34 @@ ROVE::ROVE(BaseLearner *baseLearner,
            int numParallelLearn,
            std::optional<unsigned int> randomSeed,
            const std::optional<std::string> &subsampleResultsDir,
-           bool deleteSubsampleResults)
-    : _BaseVE(baseLearner, numParallelLearn, randomSeed, subsampleResultsDir, deleteSubsampleResults),
+           bool deleteSubsampleResults,
+           StorageLayout storageLayout)
+    : _BaseVE(baseLearner, numParallelLearn, randomSeed, subsampleResultsDir, deleteSubsampleResults, storageLayout),
       _dataSplit(dataSplit),
-      _numParallelEval(std::max(1, numParallelEval))
+      _numParallelEval(numParallelEval > 0 ? numParallelEval : autoThreadConfig().numParallelEval)
 {
     if (!_baseLearner)
         throw std::invalid_argument("ROVE constructor: baseLearner cannot be null");
 }
 
+// Destructor, the jobs of runAsync call _run on this object
+ROVE::~ROVE()
+{
+    _stopAsyncPool();
+}
+
+// Number of worker threads of a single call
+int ROVE::_numThreadsPerRun() const
+{
+    return std::max(_numParallelLearn, _numParallelEval);
+}
+
+// Set the evaluation memo shared across runs
+void ROVE::setEvaluationMemo(std::shared_ptr<EvaluationMemo> memo)
+{
+    _evaluationMemo = std::move(memo);
+}
+
 // Helper function to finalize the choice for B and k
 ROVE::ROVERunParameters ROVE::_chooseParameters(long long nTotal, int B1_in, int B2_in,
                                                 std::optional<int> k1_in,
@@ -61,7 +82,7 @@ ROVE::ROVERunParameters ROVE::_chooseParameters(long long nTotal, int B1_in, int
             throw std::invalid_argument("ROVE::run: Provided k1 must be positive.");
         if (params.k1 > params.n1)
         { // print a warning
-            std::cerr << "ROVE::run: Provided k1 is larger than sample size n1. Using n1 instead." << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Warning, "ROVE::run: Provided k1 is larger than sample size n1. Using n1 instead.");
             params.k1 = static_cast<int>(params.n1);
             params.B1 = 1;
         }
@@ -82,7 +103,7 @@ ROVE::ROVERunParameters ROVE::_chooseParameters(long long nTotal, int B1_in, int
             throw std::invalid_argument("ROVE::run: Provided k2 must be positive.");
         if (params.k2 > params.n2)
         { // print a warning
-            std::cerr << "ROVE::run: Provided k2 is larger than sample size n2. Using n2 instead." << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Warning, "ROVE::run: Provided k2 is larger than sample size n2. Using n2 instead.");
             params.k2 = static_cast<int>(params.n2);
             params.B2 = 1;
         }
@@ -96,46 +117,44 @@ ROVE::ROVERunParameters ROVE::_chooseParameters(long long nTotal, int B1_in, int
     return params;
 }
 
+// Helper function to compute the work of a call
+double ROVE::_work(long long nTotal, const ROVERunParameters &params, long long k1Total)
+{
+    return static_cast<double>(nTotal) * (static_cast<double>(params.B1) * k1Total +
+                                          static_cast<double>(params.B2) * params.k2);
+}
+
 // Perform Phase I learning on subsamples to retrieve candidate solutions
-std::pair<std::vector<std::variant<Result, int>>, std::vector<std::variant<Result, int>>>
-ROVE::_runPhaseOneLearning(const Sample &sample, const ROVERunParameters &params)
-{
-    // sample.topRows(params.n1) gets the first n1 rows of the sample
-    std::vector<std::variant<Result, int>> learningResults = _learnOnSubsamples(sample.topRows(params.n1),
-                                                                                params.k1, params.B1);
-    // Remove duplicates from learningResults if needed
-    std::vector<std::variant<Result, int>> retrievedResults;
+std::pair<std::vector<std::variant<Result, int>>, _BaseVE::_DuplicateGroups>
+ROVE::_runPhaseOneLearning(_RunContext &context, const DataSource &data, const ROVERunParameters &params)
+{
+    // Learn on subsamples of the first n1 rows of the data
+    std::vector<std::variant<Result, int>> learningResults = _learnOnSubsamples(context, data, params.n1, params.k1, params.B1);
+    _DuplicateGroups groups = _retrieveCandidates(context, learningResults, 0, learningResults.size());
+    return {std::move(learningResults), std::move(groups)};
+}
+
+// Helper method to retrieve the candidates among a range of learning results
+_BaseVE::_DuplicateGroups ROVE::_retrieveCandidates(_RunContext &context,
+                                                    const std::vector<std::variant<Result, int>> &learningResults,
+                                                    size_t first, size_t count)
+{
+    /**
+     * Remove duplicates from learningResults if needed
+     * The retrieved candidates are stored as indices into learningResults to avoid copying them.
+     */
+    _DuplicateGroups groups;
     if (_baseLearner->enableDeduplication())
     {
-        std::vector<size_t> uniqueResultIndex;
-        retrievedResults.reserve(learningResults.size());
-
-        for (size_t i = 0; i < learningResults.size(); ++i)
-        {
-            Result candidate1 = _loadResultIfNeeded(learningResults[i]);
-            bool isDuplicate = false;
-            for (size_t index : uniqueResultIndex)
-            {
-                Result candidate2 = _loadResultIfNeeded(learningResults[index]);
-                if (_baseLearner->isDuplicate(candidate1, candidate2))
-                {
-                    isDuplicate = true;
-                    break;
-                }
-            }
-            if (!isDuplicate)
-            {
-                uniqueResultIndex.push_back(i);
-                retrievedResults.push_back(learningResults[i]);
-            }
-        }
-        retrievedResults.shrink_to_fit();
+        groups = _groupDuplicateResults(context, learningResults, first, count);
     }
     else
     {
-        retrievedResults = learningResults;
+        groups.uniqueIndices.resize(count);
+        std::iota(groups.uniqueIndices.begin(), groups.uniqueIndices.end(), first);
+        groups.counts.assign(count, 1);
     }
-    return {std::move(learningResults), std::move(retrievedResults)};
+    return groups;
 }
 
 // Helper method to compute the gap matrix
@@ -236,20 +255,27 @@ double ROVE::_findEpsilon(const Matrix &gapMatrix, double autoEpsilonProb)
     return right;
 }
 
-// Perform Phase II evaluation of retrieved candidates
-size_t ROVE::_runPhaseTwoEvaluation(const std::vector<std::variant<Result, int>> &retrievedResults,
-                                    double epsilon, double autoEpsilonProb,
-                                    _CachedEvaluator &cachedEvaluator,
-                                    const ROVERunParameters &params)
+// Helper method to evaluate the candidates on subsamples drawn from a range of rows
+Matrix ROVE::_evaluateCandidates(_RunContext &context, _CachedEvaluator &cachedEvaluator,
+                                 long long start, long long size, const ROVERunParameters &params)
 {
-    // Get sample indices for Phase II
-    std::vector<int> phaseTwoIndices(params.n2);
-    // Fill values, so that phaseTwoIndices = [phaseTwoStart, phaseTwoStart + 1, ..., nTotal - 1]
-    std::iota(phaseTwoIndices.begin(), phaseTwoIndices.end(), static_cast<int>(params.phaseTwoStart));
+    // Fill values, so that sampleIndices = [start, start + 1, ..., start + size - 1]
+    std::vector<int> sampleIndices(size);
+    std::iota(sampleIndices.begin(), sampleIndices.end(), static_cast<int>(start));
 
-    Matrix evalResultsPhaseTwo = cachedEvaluator._evaluateSubsamples(phaseTwoIndices, params.B2, params.k2, _rng);
-    Matrix gapMatrixPhaseTwo = _gapMatrix(evalResultsPhaseTwo);
+    return cachedEvaluator._evaluateSubsamples(sampleIndices, params.B2, params.k2, context.rng, _subsampleBlockSize);
+}
 
+Matrix ROVE::_evaluateGapMatrix(_RunContext &context, _CachedEvaluator &cachedEvaluator,
+                                long long start, long long size, const ROVERunParameters &params)
+{
+    return _gapMatrix(_evaluateCandidates(context, cachedEvaluator, start, size, params));
+}
+
+// Helper method to select the candidate with the maximum epsilon-optimal probability
+size_t ROVE::_selectCandidate(const Matrix &gapMatrixPhaseTwo, const Matrix &gapMatrixPhaseOne,
+                              double epsilon, double autoEpsilonProb) const
+{
     // Determine epsilon
     if (epsilon < 0.0)
     {
@@ -257,10 +283,6 @@ size_t ROVE::_runPhaseTwoEvaluation(const std::vector<std::variant<Result, int>>
         if (_dataSplit)
         {
             // When _dataSplit is enabled, we cannot determine epsilon using the Phase II data.
-            std::vector<int> phaseOneIndices(params.n1);
-            std::iota(phaseOneIndices.begin(), phaseOneIndices.end(), 0);
-            Matrix evalResultsPhaseOne = cachedEvaluator._evaluateSubsamples(phaseOneIndices, params.B2, params.k2, _rng);
-            Matrix gapMatrixPhaseOne = _gapMatrix(evalResultsPhaseOne);
             epsilon = _findEpsilon(gapMatrixPhaseOne, autoEpsilonProb);
         }
         else
@@ -272,7 +294,7 @@ size_t ROVE::_runPhaseTwoEvaluation(const std::vector<std::variant<Result, int>>
 
     /**
      * Compute the epsilon-optimal probability and get the candidate with the maximum probability
-     * When retrievedResults is not empty, probArray is a row vector of size (1, num_candidates)
+     * When there are retrieved candidates, probArray is a row vector of size (1, num_candidates)
      */
     RowVector probArray = _epsilonOptimalProb(gapMatrixPhaseTwo, epsilon);
     Eigen::Index bestCandidateIndex;
@@ -281,42 +303,119 @@ size_t ROVE::_runPhaseTwoEvaluation(const std::vector<std::variant<Result, int>>
     return static_cast<size_t>(bestCandidateIndex);
 }
 
+// Perform Phase II evaluation of retrieved candidates
+size_t ROVE::_runPhaseTwoEvaluation(_RunContext &context, double epsilon, double autoEpsilonProb,
+                                    _CachedEvaluator &cachedEvaluator,
+                                    const ROVERunParameters &params)
+{
+    // Evaluate on Phase II data, i.e., the rows [phaseTwoStart, nTotal)
+    Matrix gapMatrixPhaseTwo = _evaluateGapMatrix(context, cachedEvaluator, params.phaseTwoStart, params.n2, params);
+
+    // When epsilon is determined automatically with _dataSplit enabled, it is determined on Phase I data
+    Matrix gapMatrixPhaseOne;
+    if (epsilon < 0.0 && _dataSplit)
+        gapMatrixPhaseOne = _evaluateGapMatrix(context, cachedEvaluator, 0, params.n1, params);
+
+    return _selectCandidate(gapMatrixPhaseTwo, gapMatrixPhaseOne, epsilon, autoEpsilonProb);
+}
+
 // run function with all parameters specified
 Result ROVE::run(const Sample &sample,
                  int B1, int B2,
                  std::optional<int> k1, std::optional<int> k2,
                  double epsilon, double autoEpsilonProb)
+{
+    DenseDataSource data(sample);
+    return run(data, B1, B2, k1, k2, epsilon, autoEpsilonProb);
+}
+
+// run function on a DataSource
+Result ROVE::run(const DataSource &data,
+                 int B1, int B2,
+                 std::optional<int> k1, std::optional<int> k2,
+                 double epsilon, double autoEpsilonProb)
+{
+    return _run(data, B1, B2, k1, k2, epsilon, autoEpsilonProb, nullptr);
+}
+
+// Start run on the async pool
+std::future<Result> ROVE::runAsync(Sample sample,
+                                   int B1, int B2,
+                                   std::optional<int> k1, std::optional<int> k2,
+                                   double epsilon, double autoEpsilonProb,
+                                   CancellationToken cancellation)
+{
+    return _submitAsync([this, sample = std::move(sample), B1, B2, k1, k2, epsilon, autoEpsilonProb, cancellation]()
+                        {
+        cancellation.throwIfCancelled("ROVE::runAsync");
+        DenseDataSource data(sample);
+        return _run(data, B1, B2, k1, k2, epsilon, autoEpsilonProb, &cancellation); });
+}
+
+std::future<Result> ROVE::runAsync(const DataSource &data,
+                                   int B1, int B2,
+                                   std::optional<int> k1, std::optional<int> k2,
+                                   double epsilon, double autoEpsilonProb,
+                                   CancellationToken cancellation)
+{
+    return _submitAsync([this, &data, B1, B2, k1, k2, epsilon, autoEpsilonProb, cancellation]()
+                        {
+        cancellation.throwIfCancelled("ROVE::runAsync");
+        return _run(data, B1, B2, k1, k2, epsilon, autoEpsilonProb, &cancellation); });
+}
+
+// Implementation of run
+Result ROVE::_run(const DataSource &data,
+                  int B1, int B2,
+                  std::optional<int> k1, std::optional<int> k2,
+                  double epsilon, double autoEpsilonProb,
+                  const CancellationToken *cancellation)
 {
     // Validate input and determine parameters
-    long long nTotal = sample.rows();
+    long long nTotal = data.rows();
     if (nTotal == 0)
         throw std::invalid_argument("ROVE::run: Sample size n must be greater than 0.");
     if (B1 <= 0 || B2 <= 0)
         throw std::invalid_argument("ROVE::run: Number of subsamples B1 and B2 must be positive.");
 
     ROVERunParameters params = _chooseParameters(nTotal, B1, B2, k1, k2);
+    _RunContext context = _beginRun(_work(nTotal, params, params.k1), cancellation);
+    _adviseDataAccess(context, data, _CachedEvaluator::_coversMostRows(params.n2, params.B2, params.k2));
 
     /**
      * Phase I: Learn on subsamples and retrieve evaluation results
      * Note that we need to keep the original learningResults in case we need to clean up.
-     * We cannot move the clean up to here, since retrievedResults may need to access them.
+     * The retrieved candidates are indices into learningResults, so they are not copied.
      * */
-    auto [learningResults, retrievedResults] = _runPhaseOneLearning(sample, params);
-    if (retrievedResults.empty())
+    auto [learningResults, groups] = _runPhaseOneLearning(context, data, params);
+    const std::vector<size_t> &retrievedIndices = groups.uniqueIndices;
+    if (retrievedIndices.empty())
         throw std::runtime_error("ROVE::run: No learning results obtained during Phase I.");
 
     /**
      * Phase II: Epsilon-optimal voting.
-     * Note that unique_ptr.get() is used to get the raw pointer from the unique_ptr
+     * Note that unique_ptr.get() is used to get the raw pointer from the unique_ptr of the call
      */
-    _CachedEvaluator cachedEvaluator(_baseLearner, _subsampleResultIO.get(), retrievedResults, sample, _numParallelEval);
-    size_t bestCandidateIndex = _runPhaseTwoEvaluation(retrievedResults, epsilon, autoEpsilonProb, cachedEvaluator, params);
-    Result finalResult = _loadResultIfNeeded(retrievedResults[bestCandidateIndex]);
+    _CachedEvaluator cachedEvaluator(_baseLearner, context.subsampleResultIO.get(), learningResults, retrievedIndices,
+                                     data, _numWorkers(context, _numParallelEval), cancellation,
+                                     _evaluationMemo.get());
+    size_t bestCandidateIndex;
+    try
+    {
+        bestCandidateIndex = _runPhaseTwoEvaluation(context, epsilon, autoEpsilonProb, cachedEvaluator, params);
+    }
+    catch (const OperationCancelled &)
+    {
+        _cleanupSubsampleResults(context, learningResults);
+        throw;
+    }
+    Result buffer;
+    Result finalResult = _loadResultIfNeeded(context, learningResults[retrievedIndices[bestCandidateIndex]], buffer);
     if (finalResult.size() == 0)
         throw std::runtime_error("ROVE::run: The result of epsilon-optimal voting is empty.");
 
     // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
-    _cleanupSubsampleResults(learningResults);
+    _cleanupSubsampleResults(context, learningResults);
 
     return finalResult;
 }
@@ -325,4 +424,322 @@ Result ROVE::run(const Sample &sample,
 Result ROVE::run(const Sample &sample)
 {
     return run(sample, 50, 200, std::nullopt, std::nullopt, -1.0, 0.5);
+}
+
+// Run Phase I and the Phase II evaluation once, and return the epsilon-probability profile
+ROVE::EpsilonProfile ROVE::runProfile(const Sample &sample,
+                                      int B1, int B2,
+                                      std::optional<int> k1, std::optional<int> k2)
+{
+    DenseDataSource data(sample);
+    return runProfile(data, B1, B2, k1, k2);
+}
+
+ROVE::EpsilonProfile ROVE::runProfile(const DataSource &data,
+                                      int B1, int B2,
+                                      std::optional<int> k1, std::optional<int> k2)
+{
+    // Validate input and determine parameters (same as run)
+    long long nTotal = data.rows();
+    if (nTotal == 0)
+        throw std::invalid_argument("ROVE::runProfile: Sample size n must be greater than 0.");
+    if (B1 <= 0 || B2 <= 0)
+        throw std::invalid_argument("ROVE::runProfile: Number of subsamples B1 and B2 must be positive.");
+
+    ROVERunParameters params = _chooseParameters(nTotal, B1, B2, k1, k2);
+    _RunContext context = _beginRun(_work(nTotal, params, params.k1));
+    _adviseDataAccess(context, data, _CachedEvaluator::_coversMostRows(params.n2, params.B2, params.k2));
+
+    // Phase I: Learn on subsamples and retrieve candidates
+    auto [learningResults, groups] = _runPhaseOneLearning(context, data, params);
+    const std::vector<size_t> &retrievedIndices = groups.uniqueIndices;
+    if (retrievedIndices.empty())
+        throw std::runtime_error("ROVE::runProfile: No learning results obtained during Phase I.");
+
+    /**
+     * Phase II: Evaluate the candidates once. The gap matrix for determining epsilon is always computed
+     * (on Phase I data when dataSplit is enabled), so that the profile supports any autoEpsilonProb.
+     */
+    _CachedEvaluator cachedEvaluator(_baseLearner, context.subsampleResultIO.get(), learningResults, retrievedIndices,
+                                     data, _numWorkers(context, _numParallelEval), nullptr,
+                                     _evaluationMemo.get());
+    Matrix gapMatrixPhaseTwo = _evaluateGapMatrix(context, cachedEvaluator, params.phaseTwoStart, params.n2, params);
+    Matrix gapMatrixPhaseOne;
+    if (_dataSplit)
+        gapMatrixPhaseOne = _evaluateGapMatrix(context, cachedEvaluator, 0, params.n1, params);
+
+    // The profile owns the candidates, since the learning results may be cleaned up below
+    std::vector<Result> candidates;
+    candidates.reserve(retrievedIndices.size());
+    Result buffer;
+    for (size_t index : retrievedIndices)
+        candidates.push_back(_loadResultIfNeeded(context, learningResults[index], buffer));
+
+    // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
+    _cleanupSubsampleResults(context, learningResults);
+
+    return EpsilonProfile(std::move(candidates), std::move(gapMatrixPhaseTwo), std::move(gapMatrixPhaseOne));
+}
+
+// Run Phase I once and return both the MoVE and the ROVE solution
+ROVE::MoVEAndROVEResult ROVE::runWithMoVE(const Sample &sample,
+                                          int B1, int B2,
+                                          std::optional<int> k1, std::optional<int> k2,
+                                          double epsilon, double autoEpsilonProb)
+{
+    DenseDataSource data(sample);
+    return runWithMoVE(data, B1, B2, k1, k2, epsilon, autoEpsilonProb);
+}
+
+ROVE::MoVEAndROVEResult ROVE::runWithMoVE(const DataSource &data,
+                                          int B1, int B2,
+                                          std::optional<int> k1, std::optional<int> k2,
+                                          double epsilon, double autoEpsilonProb)
+{
+    if (!_baseLearner->enableDeduplication())
+        throw std::invalid_argument("ROVE::runWithMoVE: baseLearner must enable deduplication.");
+    if (_dataSplit)
+        throw std::invalid_argument("ROVE::runWithMoVE: dataSplit must be disabled.");
+
+    // Validate input and determine parameters (same as run)
+    long long nTotal = data.rows();
+    if (nTotal == 0)
+        throw std::invalid_argument("ROVE::runWithMoVE: Sample size n must be greater than 0.");
+    if (B1 <= 0 || B2 <= 0)
+        throw std::invalid_argument("ROVE::runWithMoVE: Number of subsamples B1 and B2 must be positive.");
+
+    ROVERunParameters params = _chooseParameters(nTotal, B1, B2, k1, k2);
+    _RunContext context = _beginRun(_work(nTotal, params, params.k1));
+    _adviseDataAccess(context, data, _CachedEvaluator::_coversMostRows(params.n2, params.B2, params.k2));
+
+    // Phase I: Learn on subsamples once, the groups give both the MoVE vote and the ROVE candidates
+    auto [learningResults, groups] = _runPhaseOneLearning(context, data, params);
+    if (groups.uniqueIndices.empty())
+        throw std::runtime_error("ROVE::runWithMoVE: No learning results obtained during Phase I.");
+
+    MoVEAndROVEResult combined;
+    combined.numCandidates = groups.uniqueIndices.size();
+    Result buffer;
+    combined.moveResult = _loadResultIfNeeded(context, learningResults[groups.uniqueIndices[groups.majorityIndex]], buffer);
+
+    // Phase II: Epsilon-optimal voting on the same candidates
+    _CachedEvaluator cachedEvaluator(_baseLearner, context.subsampleResultIO.get(), learningResults, groups.uniqueIndices,
+                                     data, _numWorkers(context, _numParallelEval), nullptr,
+                                     _evaluationMemo.get());
+    size_t bestCandidateIndex = _runPhaseTwoEvaluation(context, epsilon, autoEpsilonProb, cachedEvaluator, params);
+    combined.roveResult = _loadResultIfNeeded(context, learningResults[groups.uniqueIndices[bestCandidateIndex]], buffer);
+    if (combined.moveResult.size() == 0 || combined.roveResult.size() == 0)
+        throw std::runtime_error("ROVE::runWithMoVE: The result of voting is empty.");
+
+    // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
+    _cleanupSubsampleResults(context, learningResults);
+
+    return combined;
+}
+
+// Run ROVE for every Phase I subsample size in k1Grid with nested subsamples
+ROVE::SweepResult ROVE::runSweep(const Sample &sample, const std::vector<int> &k1Grid,
+                                 int B1, int B2, std::optional<int> k2,
+                                 double epsilon, double autoEpsilonProb)
+{
+    DenseDataSource data(sample);
+    return runSweep(data, k1Grid, B1, B2, k2, epsilon, autoEpsilonProb);
+}
+
+ROVE::SweepResult ROVE::runSweep(const DataSource &data, const std::vector<int> &k1Grid,
+                                 int B1, int B2, std::optional<int> k2,
+                                 double epsilon, double autoEpsilonProb)
+{
+    // Validate input and determine parameters (k1 is given by the grid)
+    long long nTotal = data.rows();
+    if (nTotal == 0)
+        throw std::invalid_argument("ROVE::runSweep: Sample size n must be greater than 0.");
+    if (B1 <= 0 || B2 <= 0)
+        throw std::invalid_argument("ROVE::runSweep: Number of subsamples B1 and B2 must be positive.");
+
+    ROVERunParameters params = _chooseParameters(nTotal, B1, B2, std::nullopt, k2);
+    SweepResult sweep;
+    sweep.kGrid = _normalizeKGrid(k1Grid, params.n1, "ROVE::runSweep");
+    _RunContext context = _beginRun(_work(nTotal, params, std::accumulate(sweep.kGrid.begin(), sweep.kGrid.end(), 0LL)));
+    _adviseDataAccess(context, data, _CachedEvaluator::_coversMostRows(params.n2, params.B2, params.k2));
+    size_t numK = sweep.kGrid.size();
+
+    // Phase I: Learning results of size numK * B1, the results of the i-th size start at i * B1
+    std::vector<std::variant<Result, int>> learningResults =
+        _learnOnNestedSubsamples(context, data, params.n1, sweep.kGrid, params.B1);
+
+    // Retrieve the candidates of each size, and concatenate them for a single evaluation
+    std::vector<_DuplicateGroups> groups;
+    std::vector<size_t> allCandidateIndices;
+    std::vector<Eigen::Index> columnStart; // First column of the candidates of each size in the evaluation
+    for (size_t i = 0; i < numK; ++i)
+    {
+        groups.push_back(_retrieveCandidates(context, learningResults, i * params.B1, params.B1));
+        columnStart.push_back(static_cast<Eigen::Index>(allCandidateIndices.size()));
+        allCandidateIndices.insert(allCandidateIndices.end(),
+                                   groups.back().uniqueIndices.begin(), groups.back().uniqueIndices.end());
+    }
+
+    // Phase II: Evaluate the candidates of all sizes on the same subsamples
+    _CachedEvaluator cachedEvaluator(_baseLearner, context.subsampleResultIO.get(), learningResults, allCandidateIndices,
+                                     data, _numWorkers(context, _numParallelEval), nullptr,
+                                     _evaluationMemo.get());
+    Matrix evalPhaseTwo = _evaluateCandidates(context, cachedEvaluator, params.phaseTwoStart, params.n2, params);
+    Matrix evalPhaseOne;
+    if (epsilon < 0.0 && _dataSplit)
+        evalPhaseOne = _evaluateCandidates(context, cachedEvaluator, 0, params.n1, params);
+
+    Result buffer;
+    for (size_t i = 0; i < numK; ++i)
+    {
+        /**
+         * The candidates retrieved from the first b + 1 subsamples are a prefix of the candidates, since
+         * uniqueIndices is in ascending order. The selection only changes when this prefix grows, and is then
+         * recomputed on the whole prefix (see the cost in the header), so that it equals the selection of run.
+         */
+        const std::vector<size_t> &uniqueIndices = groups[i].uniqueIndices;
+        std::vector<size_t> selectedByPrefix(params.B1);
+        Eigen::Index lastNumCandidates = 0;
+        size_t lastSelected = 0;
+        for (int b = 0; b < params.B1; ++b)
+        {
+            size_t end = i * params.B1 + b + 1;
+            Eigen::Index numCandidates = std::upper_bound(uniqueIndices.begin(), uniqueIndices.end(), end - 1) -
+                                         uniqueIndices.begin();
+            if (numCandidates != lastNumCandidates)
+            {
+                Matrix gapMatrixPhaseTwo = _gapMatrix(evalPhaseTwo.middleCols(columnStart[i], numCandidates));
+                Matrix gapMatrixPhaseOne;
+                if (evalPhaseOne.size() > 0)
+                    gapMatrixPhaseOne = _gapMatrix(evalPhaseOne.middleCols(columnStart[i], numCandidates));
+                lastSelected = _selectCandidate(gapMatrixPhaseTwo, gapMatrixPhaseOne, epsilon, autoEpsilonProb);
+                lastNumCandidates = numCandidates;
+            }
+            selectedByPrefix[b] = lastSelected;
+        }
+
+        std::vector<Result> candidates;
+        candidates.reserve(uniqueIndices.size());
+        for (size_t index : uniqueIndices)
+            candidates.push_back(_loadResultIfNeeded(context, learningResults[index], buffer));
+        sweep.candidates.push_back(std::move(candidates));
+        sweep.selectedByPrefix.push_back(std::move(selectedByPrefix));
+    }
+
+    // Clean up (optionally run, depending on the value of _deleteSubsampleResults)
+    _cleanupSubsampleResults(context, learningResults);
+
+    return sweep;
+}
+
+// EpsilonProfile constructor, sort each column of the gap matrices
+ROVE::EpsilonProfile::EpsilonProfile(std::vector<Result> candidates, Matrix gapMatrix, Matrix epsilonGapMatrix)
+    : _candidates(std::move(candidates)),
+      _sortedGaps(std::move(gapMatrix)),
+      _sortedEpsilonGaps(std::move(epsilonGapMatrix))
+{
+    if (_candidates.empty() || _sortedGaps.rows() == 0)
+        throw std::invalid_argument("ROVE::EpsilonProfile: candidates and gapMatrix cannot be empty");
+    if (_sortedGaps.cols() != static_cast<Eigen::Index>(_candidates.size()))
+        throw std::invalid_argument("ROVE::EpsilonProfile: gapMatrix must have one column per candidate");
+    if (_sortedEpsilonGaps.size() > 0 && _sortedEpsilonGaps.cols() != _sortedGaps.cols())
+        throw std::invalid_argument("ROVE::EpsilonProfile: epsilonGapMatrix must have one column per candidate");
+
+    // Eigen stores matrices in column-major order, so each column is a contiguous range
+    for (Matrix *gaps : {&_sortedGaps, &_sortedEpsilonGaps})
+    {
+        for (Eigen::Index c = 0; c < gaps->cols(); ++c)
+            std::sort(gaps->col(c).data(), gaps->col(c).data() + gaps->rows());
+    }
+}
+
+// Number of gaps in column of sortedGaps that are smaller than or equal to epsilon
+Eigen::Index ROVE::EpsilonProfile::_countWithin(const Matrix &sortedGaps, Eigen::Index column, double epsilon)
+{
+    const double *begin = sortedGaps.col(column).data();
+    const double *end = begin + sortedGaps.rows();
+    return std::upper_bound(begin, end, epsilon) - begin;
+}
+
+size_t ROVE::EpsilonProfile::numCandidates() const
+{
+    return _candidates.size();
+}
+
+const Result &ROVE::EpsilonProfile::candidate(size_t candidateIndex) const
+{
+    if (candidateIndex >= _candidates.size())
+        throw std::out_of_range("ROVE::EpsilonProfile::candidate: candidateIndex out of range");
+    return _candidates[candidateIndex];
+}
+
+const Matrix &ROVE::EpsilonProfile::sortedGaps() const
+{
+    return _sortedGaps;
+}
+
+RowVector ROVE::EpsilonProfile::epsilonOptimalProb(double epsilon) const
+{
+    RowVector probArray(_sortedGaps.cols());
+    for (Eigen::Index c = 0; c < _sortedGaps.cols(); ++c)
+        probArray(c) = static_cast<double>(_countWithin(_sortedGaps, c, epsilon)) / static_cast<double>(_sortedGaps.rows());
+    return probArray;
+}
+
+double ROVE::EpsilonProfile::findEpsilon(double autoEpsilonProb) const
+{
+    autoEpsilonProb = std::min(std::max(autoEpsilonProb, 0.0), 1.0);
+    const Matrix &gaps = _sortedEpsilonGaps.size() > 0 ? _sortedEpsilonGaps : _sortedGaps;
+    Eigen::Index B = gaps.rows();
+
+    /**
+     * The epsilon-optimal probability of a candidate is m / B, where m is the number of its gaps within epsilon.
+     * Find the smallest m with m / B >= autoEpsilonProb (computed as in ROVE::_epsilonOptimalProb to match
+     * its rounding), then the answer is the smallest m-th order statistic among all candidates.
+     */
+    Eigen::Index m = std::min(B, std::max<Eigen::Index>(0, static_cast<Eigen::Index>(std::ceil(autoEpsilonProb * B))));
+    while (m > 0 && static_cast<double>(m - 1) / static_cast<double>(B) >= autoEpsilonProb)
+        --m;
+    while (m < B && static_cast<double>(m) / static_cast<double>(B) < autoEpsilonProb)
+        ++m;
+    if (m == 0)
+        return 0.0;
+
+    // Gaps are nonnegative, so the result is at least 0
+    return std::max(0.0, gaps.row(m - 1).minCoeff());
+}
+
+size_t ROVE::EpsilonProfile::selectIndex(double epsilon) const
+{
+    if (epsilon < 0.0)
+        throw std::invalid_argument("ROVE::EpsilonProfile::selectIndex: epsilon must be nonnegative");
+
+    // Pick the first candidate with the maximum count, same as Eigen's maxCoeff in ROVE::run
+    Eigen::Index bestCandidateIndex = 0;
+    Eigen::Index bestCount = -1;
+    for (Eigen::Index c = 0; c < _sortedGaps.cols(); ++c)
+    {
+        Eigen::Index count = _countWithin(_sortedGaps, c, epsilon);
+        if (count > bestCount)
+        {
+            bestCount = count;
+            bestCandidateIndex = c;
+        }
+    }
+    return static_cast<size_t>(bestCandidateIndex);
+}
+
+size_t ROVE::EpsilonProfile::selectIndexAuto(double autoEpsilonProb) const
+{
+    return selectIndex(findEpsilon(autoEpsilonProb));
+}
+
+const Result &ROVE::EpsilonProfile::select(double epsilon) const
+{
+    return _candidates[selectIndex(epsilon)];
+}
+
+const Result &ROVE::EpsilonProfile::selectAuto(double autoEpsilonProb) const
+{
+    return _candidates[selectIndexAuto(autoEpsilonProb)];
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "SyntheticLearner.hpp"
+#include "types.hpp"
+
+#include <vector>
+#include <cmath>     // For std::log
+#include <chrono>    // For busy-waiting
+#include <cstring>   // For std::memcpy
+#include <stdexcept> // For exceptions
+#include <istream>
+#include <ostream>
+
+// Draw a cost in microseconds
+double CostModel::draw(std::mt19937_64 &rng) const
+{
+    switch (distribution)
+    {
+    case CostDistribution::LogNormal:
+        // std::lognormal_distribution(m, s) has median exp(m)
+        return medianMicros > 0.0 ? std::lognormal_distribution<double>(std::log(medianMicros), sigma)(rng) : 0.0;
+    case CostDistribution::Stragglers:
+        return std::bernoulli_distribution(stragglerProb)(rng) ? medianMicros * stragglerFactor : medianMicros;
+    case CostDistribution::Constant:
+    default:
+        return medianMicros;
+    }
+}
+
+// Busy-wait for the given number of microseconds
+void spinForMicros(double micros)
+{
+    if (micros <= 0.0)
+        return;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::micro>(micros);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+// Busy-wait, polling cancellation
+void spinForMicros(double micros, const CancellationToken &cancellation, const std::string &caller)
+{
+    if (micros <= 0.0)
+        return;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::micro>(micros);
+    while (std::chrono::steady_clock::now() < end)
+        cancellation.throwIfCancelled(caller);
+}
+
+// Constructor
+SyntheticLearner::SyntheticLearner(const SyntheticLearnerConfig &config)
+    : _config(config)
+{
+    if (_config.resultSize <= 0)
+        throw std::invalid_argument("SyntheticLearner constructor: resultSize must be positive");
+    if (_config.duplicateRate < 0.0 || _config.duplicateRate > 1.0)
+        throw std::invalid_argument("SyntheticLearner constructor: duplicateRate must be in [0, 1]");
+    if (_config.duplicateRate > 0.0 && _config.numDuplicateCandidates <= 0)
+        throw std::invalid_argument("SyntheticLearner constructor: numDuplicateCandidates must be positive");
+}
+
+const SyntheticLearnerConfig &SyntheticLearner::config() const
+{
+    return _config;
+}
+
+// Seed derived from the content of the sample (FNV-1a over the first column) and the configured seed
+std::uint64_t SyntheticLearner::_sampleSeed(const Sample &sample) const
+{
+    std::uint64_t hash = 14695981039346656037ULL ^ _config.seed;
+    for (Eigen::Index i = 0; i < sample.rows(); ++i)
+    {
+        double value = sample(i, 0);
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        hash ^= bits;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+Result SyntheticLearner::learn(const Sample &sample)
+{
+    return _learn(sample, nullptr);
+}
+
+Result SyntheticLearner::learnCancellable(const Sample &sample, const CancellationToken &cancellation)
+{
+    return _learn(sample, &cancellation);
+}
+
+Result SyntheticLearner::_learn(const Sample &sample, const CancellationToken *cancellation)
+{
+    if (sample.rows() == 0 || sample.cols() == 0)
+        throw std::invalid_argument("SyntheticLearner::learn: Sample must be nonempty");
+
+    std::mt19937_64 rng(_sampleSeed(sample));
+    if (cancellation)
+        spinForMicros(_config.learnCost.draw(rng), *cancellation, "SyntheticLearner::learnCancellable");
+    else
+        spinForMicros(_config.learnCost.draw(rng));
+
+    Result result(_config.resultSize);
+    if (std::bernoulli_distribution(_config.duplicateRate)(rng))
+    {
+        // One of the shared results: all entries equal to the index of the shared result
+        int shared = std::uniform_int_distribution<int>(0, _config.numDuplicateCandidates - 1)(rng);
+        result.setConstant(static_cast<double>(shared));
+    }
+    else
+    {
+        // A unique result
+        std::normal_distribution<double> dist(0.0, 1.0);
+        for (Eigen::Index i = 0; i < result.size(); ++i)
+            result(i) = dist(rng);
+    }
+    return result;
+}
+
+Vector SyntheticLearner::objective(const Result &learningResult, const Sample &sample) const
+{
+    if (sample.rows() == 0)
+        throw std::invalid_argument("SyntheticLearner::objective: Sample must be nonempty");
+
+    // The cost is drawn per call (seeded from the rows, as in learn) and scaled by the number of rows
+    std::mt19937_64 rng(_sampleSeed(sample) ^ 0x9E3779B97F4A7C15ULL);
+    spinForMicros(_config.objectiveCostPerRow.draw(rng) * static_cast<double>(sample.rows()));
+
+    return (sample.rowwise().sum().array() - learningResult.sum()).square();
+}
+
+bool SyntheticLearner::isMinimization() const
+{
+    return true;
+}
+
+bool SyntheticLearner::enableDeduplication() const
+{
+    return _config.enableDeduplication;
+}
+
+bool SyntheticLearner::isDuplicate(const Result &result1, const Result &result2) const
+{
+    if (result1.size() != result2.size())
+        return false;
+    return (result1 - result2).lpNorm<1>() < tolerance;
+}
+
+Eigen::Index SyntheticLearner::findDuplicate(const Result &result, const Eigen::Ref<const Matrix> &uniqueSet) const
+{
+    return findDuplicateByL1Distance(result, uniqueSet, tolerance);
+}
+
+// Serialization: size, data, padding size, padding (incompressible, so that compression cannot remove it)
+void SyntheticLearner::dumpLearningResult(const Result &learningResult, std::ostream &out) const
+{
+    BaseLearner::dumpLearningResult(learningResult, out);
+
+    size_t resultBytes = sizeof(Eigen::Index) + static_cast<size_t>(learningResult.size()) * sizeof(double);
+    std::uint64_t paddingBytes = _config.serializedBytes > resultBytes + sizeof(std::uint64_t)
+                                     ? _config.serializedBytes - resultBytes - sizeof(std::uint64_t)
+                                     : 0;
+    out.write(reinterpret_cast<const char *>(&paddingBytes), sizeof(paddingBytes));
+
+    std::vector<char> padding(paddingBytes);
+    std::mt19937_64 rng(_config.seed);
+    for (char &byte : padding)
+        byte = static_cast<char>(rng());
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    if (!out)
+        throw std::runtime_error("SyntheticLearner::dumpLearningResult: Failed to write padding to output stream.");
+}
+
+Result SyntheticLearner::loadLearningResult(std::istream &in) const
+{
+    Result learningResult = BaseLearner::loadLearningResult(in);
+
+    std::uint64_t paddingBytes = 0;
+    in.read(reinterpret_cast<char *>(&paddingBytes), sizeof(paddingBytes));
+    if (!in)
+        throw std::runtime_error("SyntheticLearner::loadLearningResult: Failed to read padding size from input stream.");
+    in.ignore(static_cast<std::streamsize>(paddingBytes));
+    if (static_cast<std::uint64_t>(in.gcount()) != paddingBytes)
+        throw std::runtime_error("SyntheticLearner::loadLearningResult: Failed to read padding from input stream.");
+    return learningResult;
+}
+
+Sample generateSyntheticData(size_t n, int p, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> dist(0.0, 1.0);
+    return Sample::NullaryExpr(n, p, [&]()
+                               { return dist(rng); });
+}
@@ -0,0 +1,195 @@
+#include "ThreadConfig.hpp"
+
+#include <string>
+#include <vector>
+#include <set>       // For the distinct SMT sibling lists
+#include <fstream>   // For reading cgroup and sysfs files
+#include <sstream>   // For std::ostringstream
+#include <algorithm> // For std::min, std::max
+#include <cmath>     // For std::ceil
+#include <cstdlib>   // For std::getenv, std::strtol
+#include <thread>    // For std::thread::hardware_concurrency
+
+#ifdef __linux__
+#include <sched.h> // For sched_getaffinity
+#endif
+
+namespace
+{
+    // Read the first line of a file, empty if the file cannot be read
+    std::string readFirstLine(const std::string &path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        if (in)
+            std::getline(in, line);
+        return line;
+    }
+
+    // Number of CPUs reported by the standard library, at least 1
+    int hardwareConcurrency()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+#ifdef __linux__
+    // CPUs in the affinity mask of the process, empty if it cannot be read
+    std::vector<int> affinityCpus()
+    {
+        std::vector<int> cpus;
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &mask))
+                    cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    // CPU limit from a quota and a period, 0 if there is no limit
+    double quotaToCpus(long long quota, long long period)
+    {
+        if (quota <= 0 || period <= 0)
+            return 0.0;
+        return static_cast<double>(quota) / static_cast<double>(period);
+    }
+
+    /**
+     * CPU quota of the cgroup of the process in number of CPUs, 0 if there is no limit.
+     * The cgroup path is read from /proc/self/cgroup. All ancestors are checked, since a limit
+     * on a parent cgroup also applies to its children. The most restrictive limit is returned.
+     */
+    double cgroupCpuQuota()
+    {
+        double limit = 0.0;
+        auto applyLimit = [&limit](double cpus)
+        {
+            if (cpus > 0.0 && (limit == 0.0 || cpus < limit))
+                limit = cpus;
+        };
+
+        std::ifstream cgroupFile("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(cgroupFile, line))
+        {
+            // Each line looks like "hierarchy-ID:controller-list:cgroup-path"
+            size_t first = line.find(':');
+            size_t second = line.find(':', first + 1);
+            if (first == std::string::npos || second == std::string::npos)
+                continue;
+            std::string hierarchy = line.substr(0, first);
+            std::string controllers = line.substr(first + 1, second - first - 1);
+            std::string path = line.substr(second + 1);
+
+            bool isV2 = (hierarchy == "0" && controllers.empty());
+            bool isV1Cpu = (("," + controllers + ",").find(",cpu,") != std::string::npos);
+            if (!isV2 && !isV1Cpu)
+                continue;
+
+            // Walk from the cgroup of the process up to the root
+            while (true)
+            {
+                if (isV2)
+                {
+                    // cpu.max looks like "max 100000" (no limit) or "200000 100000"
+                    std::istringstream cpuMax(readFirstLine("/sys/fs/cgroup" + path + "/cpu.max"));
+                    std::string quota;
+                    long long period = 0;
+                    if (cpuMax >> quota >> period && quota != "max")
+                        applyLimit(quotaToCpus(std::atoll(quota.c_str()), period));
+                }
+                else
+                {
+                    for (const char *mount : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"})
+                    {
+                        std::string quota = readFirstLine(std::string(mount) + path + "/cpu.cfs_quota_us");
+                        std::string period = readFirstLine(std::string(mount) + path + "/cpu.cfs_period_us");
+                        if (!quota.empty() && !period.empty())
+                            applyLimit(quotaToCpus(std::atoll(quota.c_str()), std::atoll(period.c_str())));
+                    }
+                }
+
+                if (path.empty() || path == "/")
+                    break;
+                size_t slash = path.find_last_of('/');
+                path = (slash == 0 || slash == std::string::npos) ? "/" : path.substr(0, slash);
+            }
+        }
+        return limit;
+    }
+
+    // Number of distinct physical cores among the given CPUs, 0 if the topology cannot be read
+    int physicalCoreCount(const std::vector<int> &cpus)
+    {
+        std::set<std::string> siblingLists;
+        for (int cpu : cpus)
+        {
+            std::string siblings = readFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                                                 "/topology/thread_siblings_list");
+            if (siblings.empty())
+                return 0;
+            siblingLists.insert(siblings);
+        }
+        return static_cast<int>(siblingLists.size());
+    }
+#endif
+
+    ThreadConfig detectThreadConfig()
+    {
+        ThreadConfig config;
+        config.availableCpus = hardwareConcurrency();
+        config.physicalCores = config.availableCpus;
+
+#ifdef __linux__
+        std::vector<int> cpus = affinityCpus();
+        if (!cpus.empty())
+            config.availableCpus = static_cast<int>(cpus.size());
+
+        // A fractional quota (e.g., 1.5 CPUs) is rounded up, so that the quota can be fully used
+        double quota = cgroupCpuQuota();
+        if (quota > 0.0)
+            config.availableCpus = std::min(config.availableCpus, std::max(1, static_cast<int>(std::ceil(quota))));
+
+        int cores = cpus.empty() ? 0 : physicalCoreCount(cpus);
+        config.physicalCores = cores > 0 ? cores : config.availableCpus;
+#endif
+
+        config.availableCpus = std::max(1, config.availableCpus);
+        config.physicalCores = std::max(1, std::min(config.physicalCores, config.availableCpus));
+        config.numParallelLearn = config.physicalCores;
+        config.numParallelEval = config.availableCpus;
+
+        // Explicit override of the worker counts of both phases
+        if (const char *env = std::getenv("VOTE_ENSEMBLE_NUM_THREADS"))
+        {
+            long value = std::strtol(env, nullptr, 10);
+            if (value > 0)
+            {
+                config.numParallelLearn = static_cast<int>(value);
+                config.numParallelEval = static_cast<int>(value);
+            }
+        }
+        return config;
+    }
+}
+
+std::string ThreadConfig::toString() const
+{
+    std::ostringstream out;
+    out << "availableCpus=" << availableCpus
+        << ", physicalCores=" << physicalCores
+        << ", numParallelLearn=" << numParallelLearn
+        << ", numParallelEval=" << numParallelEval;
+    return out.str();
+}
+
+const ThreadConfig &autoThreadConfig()
+{
+    // Function-local static, initialized once in a thread-safe way
+    static const ThreadConfig config = detectThreadConfig();
+    return config;
+}
@@ -0,0 +1,25 @@
+#include "ToolUtils.hpp"
+
+#include <algorithm> // For std::min
+
+const char *layoutName(const std::optional<StorageLayout> &layout)
+{
+    if (!layout)
+        return "memory";
+    switch (*layout)
+    {
+    case StorageLayout::FixedStride:
+        return "fixed-stride";
+    case StorageLayout::FixedStrideChecked:
+        return "fixed-stride-checked";
+    case StorageLayout::Compressed:
+    default:
+        return "compressed";
+    }
+}
+
+double percentile(const std::vector<double> &sorted, double q)
+{
+    size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size()) + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "types.hpp" // For StorageLayout
+
+#include <vector>
+#include <optional> // For std::optional
+
+/**
+ * Helper functions shared by the command-line tools (benchmark and replay).
+ * They are not part of the library.
+ */
+
+// Name of a storage layout in the output of the tools, "memory" if the results are kept in memory
+const char *layoutName(const std::optional<StorageLayout> &layout);
+
+// Value at quantile q of sorted values (nearest rank), sorted must not be empty
+double percentile(const std::vector<double> &sorted, double q);
@@ -6,6 +6,12 @@
 #include <optional>  // For std::optional
 #include <stdexcept> // For std::exception
 
+// Format the number of threads for printing, "auto" when chosen by autoThreadConfig
+static std::string formatNumThreads(int numThreads)
+{
+    return numThreads > 0 ? std::to_string(numThreads) : "auto";
+}
+
 void runMoVE(
     const std::string &experimentName,
     BaseLearner *baseLearnerPtr,
@@ -18,7 +24,7 @@ void runMoVE(
     std::optional<int> k)
 {
     std::cout << "\nRunning MoVE with " << experimentName << " (numThreads="
-              << numThreads << ", seed=" << seed
+              << formatNumThreads(numThreads) << ", seed=" << seed
               << ", B=" << B << ", k=" << (k ? std::to_string(*k) : "null") << ")..." << std::endl;
 
     if (subsampleResultsDir)
@@ -59,7 +65,7 @@ void runROVE(
     double autoEpsilonProb)
 {
     std::cout << "\nRunning ROVE with " << experimentName << " (dataSplit="
-              << std::boolalpha << dataSplit << ", numThreads=" << numThreads
+              << std::boolalpha << dataSplit << ", numThreads=" << formatNumThreads(numThreads)
               << ", seed=" << seed << ", B1=" << B1 << ", B2=" << B2
               << ", k1=" << (k1 ? std::to_string(*k1) : "null")
               << ", k2=" << (k2 ? std::to_string(*k2) : "null")
@@ -87,4 +93,51 @@ void runROVE(
     {
         std::cerr << "Error during ROVE execution: " << e.what() << std::endl;
     }
-}
\ No newline at end of file
+}
+
+void runMoVEAndROVE(
+    const std::string &experimentName,
+    BaseLearner *baseLearnerPtr,
+    const Sample &sample,
+    int numThreads,
+    unsigned int seed,
+    const std::optional<std::string> &subsampleResultsDir,
+    bool deleteSubsampleResults,
+    int B1, int B2,
+    std::optional<int> k1,
+    std::optional<int> k2,
+    double epsilon,
+    double autoEpsilonProb)
+{
+    std::cout << "\nRunning MoVE and ROVE with shared Phase I with " << experimentName
+              << " (numThreads=" << formatNumThreads(numThreads)
+              << ", seed=" << seed << ", B1=" << B1 << ", B2=" << B2
+              << ", k1=" << (k1 ? std::to_string(*k1) : "null")
+              << ", k2=" << (k2 ? std::to_string(*k2) : "null")
+              << ", epsilon=" << epsilon
+              << ", autoEpsilonProb=" << autoEpsilonProb << ")..." << std::endl;
+
+    if (subsampleResultsDir)
+    {
+        std::cout << "Subsample results will be stored in: " << *subsampleResultsDir
+                  << " (delete=" << std::boolalpha << deleteSubsampleResults << ")" << std::endl;
+    }
+    else
+    {
+        std::cout << "External storage for subsample results is disabled." << std::endl;
+    }
+
+    try
+    { // numThreads for both learning and evaluation
+        ROVE rove(baseLearnerPtr, false, numThreads, numThreads, {seed}, subsampleResultsDir, deleteSubsampleResults);
+        ROVE::MoVEAndROVEResult combined = rove.runWithMoVE(sample, B1, B2, k1, k2, epsilon, autoEpsilonProb);
+
+        std::cout << "Number of distinct candidates: " << combined.numCandidates << std::endl;
+        printResult(experimentName + " MoVE solution: ", combined.moveResult);
+        printResult(experimentName + " ROVE solution: ", combined.roveResult);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error during MoVE and ROVE execution: " << e.what() << std::endl;
+    }
+}
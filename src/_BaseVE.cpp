@@ -1,6 +1,10 @@
 #include "BaseLearner.hpp"
 #include "_BaseVE.hpp"
 #include "_SubsampleResultIO.hpp"
+#include "_ThreadPool.hpp"
+#include "ThreadConfig.hpp"
+#include "Metrics.hpp"
+#include "Logger.hpp"
 #include "types.hpp"
 
 #include <vector>
@@ -8,11 +12,12 @@
 #include <variant>    // For std::variant
 #include <stdexcept>  // For std::invalid_argument, std::runtime_error
 #include <numeric>    // For std::iota
-#include <algorithm>  // For std::shuffle, std::min
+#include <algorithm>  // For std::shuffle, std::min, std::sort
 #include <future>     // For std::async, std::future
 #include <thread>     // For std::thread::hardware_concurrency (optional)
-#include <iostream>   // For std::cerr (error reporting)
 #include <chrono>     // For seeding RNG with time if no seed provided
+#include <filesystem> // For std::filesystem::create_directories
+#include <system_error> // For std::error_code
 #include <Eigen/Core> // Include Eigen Core for Map and VectorXi (if not implicitly included)
 
 // Constructor
@@ -20,9 +25,12 @@ _BaseVE::_BaseVE(BaseLearner *baseLearner,
                  int numParallelLearn,
                  std::optional<unsigned int> randomSeed,
                  const std::optional<std::string> &subsampleResultsDir,
-                 bool deleteSubsampleResults)
+                 bool deleteSubsampleResults,
+                 StorageLayout storageLayout)
     : _baseLearner(baseLearner),
-      _numParallelLearn(std::max(1, numParallelLearn)),
+      _numParallelLearn(numParallelLearn > 0 ? numParallelLearn : autoThreadConfig().numParallelLearn),
+      _subsampleResultsDir(subsampleResultsDir),
+      _storageLayout(storageLayout),
       _deleteSubsampleResults(deleteSubsampleResults)
 {
     if (!_baseLearner)
@@ -30,44 +38,261 @@ _BaseVE::_BaseVE(BaseLearner *baseLearner,
 
     // Initialize random seed (if not provided, use current time)
     _randomSeed = randomSeed.value_or(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count()));
-    _rng.seed(_randomSeed);
 
-    // Initialize _SubsampleResultIO
-    _subsampleResultIO = std::make_unique<_SubsampleResultIO>(_baseLearner, subsampleResultsDir);
-    _subsampleResultIO->_prepareSubsampleResultDir();
+    // Create the storage root now, so that an invalid directory is reported by the constructor.
+    // The run directories are only created by the calls that store subsample results.
+    if (_subsampleResultsDir)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(*_subsampleResultsDir, ec);
+        if (!std::filesystem::is_directory(*_subsampleResultsDir))
+            throw std::runtime_error("_BaseVE constructor: Error when creating directory: " + *_subsampleResultsDir +
+                                     ": " + (ec ? ec.message() : "path exists and is not a directory"));
+    }
 }
 
-// Destructor (use default, and unique_ptr will handle cleanup)
-_BaseVE::~_BaseVE() = default;
+// Destructor (unique_ptr will handle cleanup, after the pending async jobs have finished)
+_BaseVE::~_BaseVE()
+{
+    _stopAsyncPool();
+}
 
-// Reset the random seed
+// Reset the call counter
 void _BaseVE::resetRandomSeed()
 {
-    _rng.seed(_randomSeed);
+    _nextCallId = 0;
+}
+
+// Helper function to start a call
+_BaseVE::_RunContext _BaseVE::_beginRun(double work, const CancellationToken *cancellation)
+{
+    _RunContext context;
+    context.cancellation = cancellation;
+    context.callId = _nextCallId.fetch_add(1);
+    if (context.callId == 0)
+    {
+        context.rng.seed(_randomSeed);
+    }
+    else
+    {
+        std::seed_seq seeds{_randomSeed,
+                            static_cast<unsigned int>(context.callId),
+                            static_cast<unsigned int>(context.callId >> 32)};
+        context.rng.seed(seeds);
+    }
+
+    // Small problems keep their results in memory, so there is no directory to prepare
+    context.inlineExecution = work <= _smallProblemThreshold;
+    if (context.inlineExecution)
+    {
+        context.subsampleResultIO = std::make_unique<_SubsampleResultIO>(_baseLearner, std::nullopt, _storageLayout);
+        return context;
+    }
+
+    // Each call gets its own namespace directory (if external storage is enabled)
+    context.subsampleResultIO = std::make_unique<_SubsampleResultIO>(_baseLearner, _subsampleResultsDir, _storageLayout,
+                                                                     _directStorageIO);
+    context.subsampleResultIO->_prepareSubsampleResultDir();
+    // Results that are not kept are removed with the context, also when the call throws
+    context.subsampleResultIO->_setRemoveRunDirOnDestruction(_deleteSubsampleResults);
+
+    if (const auto &runDir = context.subsampleResultIO->getRunDir())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lastRunDirMutex);
+            _lastRunDir = runDir->string();
+        }
+        if (!_deleteSubsampleResults)
+            VOTE_ENSEMBLE_LOG(LogLevel::Info, "_BaseVE::_beginRun: The subsample results of call " << context.callId
+                                                  << " are kept in " << runDir->string());
+    }
+    return context;
+}
+
+// Helper function to advise the access pattern of a call on data
+void _BaseVE::_adviseDataAccess(const _RunContext &context, const DataSource &data, bool sequentialScan) const
+{
+    if (!context.inlineExecution)
+        data.adviseAccess(_subsampleBlockSize == 1 && !sequentialScan);
+}
+
+// Helper function to get the number of workers of a call
+int _BaseVE::_numWorkers(const _RunContext &context, int numParallel, int numTasks)
+{
+    return context.inlineExecution ? 1 : std::max(1, std::min(numParallel, numTasks));
+}
+
+// Helper function to check whether cancellation of a call was requested
+bool _BaseVE::_isCancelled(const _RunContext &context)
+{
+    return context.cancellation && context.cancellation->isCancelled();
+}
+
+// Helper function to stop a cancelled call
+void _BaseVE::_stopIfCancelled(_RunContext &context, const std::vector<std::variant<Result, int>> &learningResults,
+                               const std::string &caller)
+{
+    if (!_isCancelled(context))
+        return;
+    _cleanupSubsampleResults(context, learningResults);
+    context.cancellation->throwIfCancelled(caller);
+}
+
+// Number of worker threads of a single call
+int _BaseVE::_numThreadsPerRun() const
+{
+    return _numParallelLearn;
+}
+
+// Helper function to run a job on the async pool
+std::future<Result> _BaseVE::_submitAsync(std::function<Result()> job)
+{
+    std::lock_guard<std::mutex> lock(_asyncPoolMutex);
+    if (!_asyncPool)
+    {
+        // By default, the runs in progress together use about one thread per CPU, since each run has its own workers
+        int numWorkers = _numAsyncWorkers > 0 ? _numAsyncWorkers
+                                              : std::max(1, autoThreadConfig().availableCpus / _numThreadsPerRun());
+        _asyncPool = std::make_unique<_ThreadPool>(numWorkers);
+    }
+
+    _LibraryMetrics &metrics = _LibraryMetrics::get();
+    metrics.asyncQueueDepth.add(1);
+    try
+    {
+        return _asyncPool->submit([job = std::move(job), &metrics]()
+                                  {
+            metrics.asyncQueueDepth.add(-1);
+            Gauge::Scope runningJob(metrics.asyncRunningJobs);
+            return job(); });
+    }
+    catch (...)
+    {
+        metrics.asyncQueueDepth.add(-1);
+        throw;
+    }
+}
+
+// Helper function to stop the async pool
+void _BaseVE::_stopAsyncPool()
+{
+    std::unique_ptr<_ThreadPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(_asyncPoolMutex);
+        pool = std::move(_asyncPool);
+    }
+    pool.reset(); // Joins the threads after the queued jobs, outside the lock
+}
+
+// Set the number of threads of the async pool
+void _BaseVE::setNumAsyncWorkers(int numWorkers)
+{
+    std::lock_guard<std::mutex> lock(_asyncPoolMutex);
+    if (_asyncPool)
+        throw std::logic_error("_BaseVE::setNumAsyncWorkers: The async pool has already started.");
+    _numAsyncWorkers = numWorkers;
+}
+
+// Set the work up to which calls run inline
+void _BaseVE::setSmallProblemThreshold(double threshold)
+{
+    if (threshold < 0)
+        throw std::invalid_argument("_BaseVE::setSmallProblemThreshold: threshold cannot be negative.");
+    _smallProblemThreshold = threshold;
+}
+
+double _BaseVE::smallProblemThreshold() const
+{
+    return _smallProblemThreshold;
+}
+
+// Set the deadline of a single call to learn
+void _BaseVE::setLearnDeadline(std::chrono::microseconds deadline, int maxReplacementsPerSubsample)
+{
+    if (deadline.count() < 0)
+        throw std::invalid_argument("_BaseVE::setLearnDeadline: deadline cannot be negative.");
+    if (maxReplacementsPerSubsample < 0)
+        throw std::invalid_argument("_BaseVE::setLearnDeadline: maxReplacementsPerSubsample cannot be negative.");
+    // Without a replacement, the only attempt is the last one, which is learned without the deadline
+    if (deadline.count() > 0 && maxReplacementsPerSubsample < 1)
+        throw std::invalid_argument("_BaseVE::setLearnDeadline: maxReplacementsPerSubsample must be at least 1 when a deadline is set.");
+    _learnDeadline = deadline;
+    _maxReplacementsPerSubsample = maxReplacementsPerSubsample;
+}
+
+std::chrono::microseconds _BaseVE::learnDeadline() const
+{
+    return _learnDeadline;
+}
+
+unsigned long long _BaseVE::numReplacedSubsamples() const
+{
+    return _numReplacedSubsamples.load(std::memory_order_relaxed);
+}
+
+std::optional<std::string> _BaseVE::lastRunDir() const
+{
+    std::lock_guard<std::mutex> lock(_lastRunDirMutex);
+    return _lastRunDir;
+}
+
+void _BaseVE::setDirectStorageIO(bool enabled)
+{
+    _directStorageIO = enabled;
+}
+
+bool _BaseVE::directStorageIO() const
+{
+    return _directStorageIO;
+}
+
+// Set the number of consecutive rows drawn together in a subsample
+void _BaseVE::setSubsampleBlockSize(int blockSize)
+{
+    if (blockSize <= 0)
+        throw std::invalid_argument("_BaseVE::setSubsampleBlockSize: blockSize must be positive.");
+    _subsampleBlockSize = blockSize;
+}
+
+int _BaseVE::subsampleBlockSize() const
+{
+    return _subsampleBlockSize;
 }
 
 // Helper function to to get a candidate solution as Result
-Result _BaseVE::_loadResultIfNeeded(const std::variant<Result, int> &resultOrIndex)
+const Result &_BaseVE::_loadResultIfNeeded(_RunContext &context, const std::variant<Result, int> &resultOrIndex,
+                                           Result &buffer)
 {
     if (std::holds_alternative<Result>(resultOrIndex))
     {
-        return std::get<Result>(resultOrIndex);
+        return std::get<Result>(resultOrIndex); // Borrow the in-memory result, no copy
     }
     else
     {
-        if (!_subsampleResultIO)
+        if (!context.subsampleResultIO)
         {
-            throw std::runtime_error("_BaseVE::_loadResultIfNeeded: _subsampleResultIO is not initialized.");
+            throw std::runtime_error("_BaseVE::_loadResultIfNeeded: subsampleResultIO is not initialized.");
         }
         int index = std::get<int>(resultOrIndex);
-        return _subsampleResultIO->_loadSubsampleResult(index);
+        context.subsampleResultIO->_loadSubsampleResult(index, buffer);
+        return buffer;
     }
 }
 
 // Helper function to generate B sets of subsample indices, each of size k.
-std::vector<std::vector<int>> _BaseVE::_generateSubsampleIndices(int n, int k, int B)
+std::vector<std::vector<int>> _BaseVE::_generateSubsampleIndices(_RunContext &context, int n, int k, int B)
 {
     std::vector<std::vector<int>> subsampleIndices(B);
+    if (_subsampleBlockSize > 1)
+    {
+        for (int b = 0; b < B; ++b)
+        {
+            subsampleIndices[b] = _sampleBlockPositions(n, k, _subsampleBlockSize, context.rng);
+            std::sort(subsampleIndices[b].begin(), subsampleIndices[b].end());
+        }
+        return subsampleIndices;
+    }
+
     std::vector<int> nIndices(n);
     std::iota(nIndices.begin(), nIndices.end(), 0); // nIndices = {0, 1, ..., n-1}
 
@@ -75,31 +300,94 @@ std::vector<std::vector<int>> _BaseVE::_generateSubsampleIndices(int n, int k, i
     {
         subsampleIndices[b].reserve(k);
         // Sample k indices from nIndices
-        std::sample(nIndices.begin(), nIndices.end(), std::back_inserter(subsampleIndices[b]), k, _rng);
+        std::sample(nIndices.begin(), nIndices.end(), std::back_inserter(subsampleIndices[b]), k, context.rng);
     }
     return subsampleIndices;
 }
 
 // Helper function to learn on a single subsample.
-std::variant<Result, int> _BaseVE::_processSingleSubsample(const Sample &sample,
+std::variant<Result, int> _BaseVE::_processSingleSubsample(_RunContext &context,
+                                                           const DataSource &data,
+                                                           long long n,
                                                            const std::vector<int> &indices,
-                                                           int subsampleIndex)
-{ /**
-   * Convert indices to Eigen::VectorXi
-   * Then, create a matrix by selecting rows from sample and learn on it
-   */
-    Eigen::Map<const Eigen::VectorXi> indicesMap(indices.data(), indices.size());
-    Sample subsampleData = sample(indicesMap, Eigen::all);
-    Result learningResult = _baseLearner->learn(subsampleData);
+                                                           int subsampleIndex,
+                                                           Sample &buffer)
+{
+    // Create a matrix by selecting rows from data and learn on it
+    data.gatherRows(indices.data(), static_cast<Eigen::Index>(indices.size()), buffer);
+    Result learningResult;
+    if (_learnDeadline.count() > 0)
+    {
+        learningResult = _learnWithDeadline(context, data, n, subsampleIndex, buffer);
+    }
+    else
+    {
+        Histogram::Timer timer(_LibraryMetrics::get().learnSeconds);
+        learningResult = _baseLearner->learn(buffer);
+    }
+    _LibraryMetrics::get().subsamplesLearned.add();
+
+    return _storeLearningResult(context, std::move(learningResult), subsampleIndex);
+}
+
+// Helper function to learn on the rows in buffer under the learn deadline
+Result _BaseVE::_learnWithDeadline(_RunContext &context, const DataSource &data, long long n, int subsampleIndex,
+                                   Sample &buffer)
+{
+    // The token of the call (if any) also cancels each attempt
+    CancellationToken callToken = context.cancellation ? *context.cancellation : CancellationToken();
+    int k = static_cast<int>(buffer.rows());
+    for (int attempt = 0;; ++attempt)
+    {
+        if (attempt > 0)
+        { // Draw the replacement subsample
+            std::seed_seq seeds{_randomSeed,
+                                static_cast<unsigned int>(context.callId),
+                                static_cast<unsigned int>(context.callId >> 32),
+                                static_cast<unsigned int>(subsampleIndex),
+                                static_cast<unsigned int>(attempt)};
+            std::mt19937 rng(seeds);
+            // O(k) draw (a block size of 1 draws single rows), so a replacement does not cost O(n)
+            std::vector<int> indices = _sampleBlockPositions(static_cast<int>(n), k, _subsampleBlockSize, rng);
+            std::sort(indices.begin(), indices.end());
+            data.gatherRows(indices.data(), k, buffer);
+        }
+
+        bool lastAttempt = attempt == _maxReplacementsPerSubsample;
+        try
+        {
+            Histogram::Timer timer(_LibraryMetrics::get().learnSeconds);
+            if (lastAttempt)
+                return _baseLearner->learnCancellable(buffer, callToken);
+            return _baseLearner->learnCancellable(
+                buffer, callToken.withDeadline(std::chrono::steady_clock::now() + _learnDeadline));
+        }
+        catch (const OperationCancelled &)
+        {
+            if (lastAttempt || callToken.isCancelled())
+                throw;
+        }
 
+        _numReplacedSubsamples.fetch_add(1, std::memory_order_relaxed);
+        _LibraryMetrics::get().replacedSubsamples.add();
+        VOTE_ENSEMBLE_LOG(LogLevel::Warning, "_BaseVE::_learnOnSubsamples: Subsample " << subsampleIndex
+                                                 << " exceeded the learn deadline of " << _learnDeadline.count()
+                                                 << " microseconds and was replaced (replacement " << attempt + 1
+                                                 << " of at most " << _maxReplacementsPerSubsample << ").");
+    }
+}
+
+// Helper function to store a learning result
+std::variant<Result, int> _BaseVE::_storeLearningResult(_RunContext &context, Result learningResult, int storageIndex)
+{
     /**
-     * Store result or dump it and store the index (assume _subsampleResultIO is not null)
+     * Store result or dump it and store the index (assume context.subsampleResultIO is not null)
      * Depending on whether the external storage is enabled or not
      */
-    if (_subsampleResultIO->isExternalStorateEnabled())
+    if (context.subsampleResultIO->isExternalStorateEnabled())
     {
-        _subsampleResultIO->_dumpSubsampleResult(learningResult, subsampleIndex);
-        return subsampleIndex; // Store the index if external storage is enabled
+        context.subsampleResultIO->_dumpSubsampleResult(learningResult, storageIndex);
+        return storageIndex; // Store the index if external storage is enabled
     }
     else
     {
@@ -107,11 +395,163 @@ std::variant<Result, int> _BaseVE::_processSingleSubsample(const Sample &sample,
     }
 }
 
+// Helper function to generate B sequences of nested subsample indices
+std::vector<std::vector<int>> _BaseVE::_generateNestedSubsampleIndices(_RunContext &context, int n, int kMax, int B)
+{
+    std::vector<std::vector<int>> subsampleIndices(B);
+    if (_subsampleBlockSize > 1)
+    {
+        for (int b = 0; b < B; ++b)
+            subsampleIndices[b] = _sampleBlockPositions(n, kMax, _subsampleBlockSize, context.rng);
+        return subsampleIndices;
+    }
+
+    std::vector<int> nIndices(n);
+    std::iota(nIndices.begin(), nIndices.end(), 0); // nIndices = {0, 1, ..., n-1}
+
+    /**
+     * Partial Fisher-Yates shuffle, which costs O(kMax) per subsample.
+     * nIndices is not reset between subsamples: it stays a permutation of [0, n), and a partial shuffle of
+     * any fixed permutation gives a uniformly random sequence of kMax distinct indices.
+     */
+    for (int b = 0; b < B; ++b)
+    {
+        for (int i = 0; i < kMax; ++i)
+        {
+            int j = std::uniform_int_distribution<int>(i, n - 1)(context.rng);
+            std::swap(nIndices[i], nIndices[j]);
+        }
+        subsampleIndices[b].assign(nIndices.begin(), nIndices.begin() + kMax);
+    }
+    return subsampleIndices;
+}
+
+// Helper function to learn on nested subsamples of every size in kGrid
+std::vector<std::variant<Result, int>> _BaseVE::_learnOnNestedSubsamples(_RunContext &context, const DataSource &data,
+                                                                        long long n, const std::vector<int> &kGrid, int B)
+{
+    if (B <= 0)
+        throw std::invalid_argument("_BaseVE::_learnOnNestedSubsamples: Number of subsamples B must be positive.");
+    if (kGrid.empty())
+        throw std::invalid_argument("_BaseVE::_learnOnNestedSubsamples: kGrid cannot be empty.");
+
+    if (n > data.rows() || kGrid.front() <= 0 || kGrid.back() > n)
+        throw std::invalid_argument("_BaseVE::_learnOnNestedSubsamples: Subsample sizes must be in [1, n] and n cannot exceed the number of rows.");
+
+    int numK = static_cast<int>(kGrid.size());
+    std::vector<std::vector<int>> subsampleIndices = _generateNestedSubsampleIndices(context, n, kGrid.back(), B);
+
+    // Make room for numK * B results in external storage (only needed by the fixed-stride layout)
+    context.subsampleResultIO->_prepareSlots(numK * B);
+
+    /**
+     * Each worker handles the subsamples [startBatch, endBatch) for all sizes, and writes to disjoint
+     * elements of allResults. Within a subsample, the sizes are learned in ascending order so that the
+     * incremental state can be extended.
+     */
+    std::vector<std::variant<Result, int>> allResults(static_cast<size_t>(numK) * B);
+    bool incremental = _baseLearner->supportsIncrementalLearning();
+    auto taskLambda = [&](int startBatch, int endBatch)
+    {
+        Gauge::Scope activeWorker(_LibraryMetrics::get().activeWorkers);
+        for (int b = startBatch; b < endBatch && !_isCancelled(context); ++b)
+        {
+            std::unique_ptr<BaseLearner::IncrementalState> state;
+            if (incremental)
+                state = _baseLearner->createIncrementalState();
+
+            int learnedRows = 0;
+            Sample rows;
+            for (int i = 0; i < numK; ++i)
+            {
+                Result learningResult;
+                if (incremental)
+                { // Only gather the new rows
+                    data.gatherRows(subsampleIndices[b].data() + learnedRows, kGrid[i] - learnedRows, rows);
+                    Histogram::Timer timer(_LibraryMetrics::get().learnSeconds);
+                    learningResult = _baseLearner->learnIncremental(*state, rows);
+                }
+                else
+                {
+                    data.gatherRows(subsampleIndices[b].data(), kGrid[i], rows);
+                    Histogram::Timer timer(_LibraryMetrics::get().learnSeconds);
+                    learningResult = _baseLearner->learn(rows);
+                }
+                _LibraryMetrics::get().subsamplesLearned.add();
+                learnedRows = kGrid[i];
+
+                int storageIndex = i * B + b;
+                allResults[storageIndex] = _storeLearningResult(context, std::move(learningResult), storageIndex);
+            }
+        }
+    };
+
+    int numWorkers = _numWorkers(context, _numParallelLearn, B);
+    int tasksPerWorker = B / numWorkers;
+    int remainingTasks = B % numWorkers;
+    int startIndex = 0;
+    std::vector<std::future<void>> futures;
+    futures.reserve(numWorkers);
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        int endIndex = startIndex + tasksPerWorker + (w < remainingTasks ? 1 : 0); // Distribute remaining tasks
+        futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, startIndex, endIndex));
+        startIndex = endIndex;
+    }
+
+    // Wait for all workers before rethrowing, since they write to allResults
+    std::string error;
+    for (auto &future : futures)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (const std::exception &e)
+        {
+            if (error.empty())
+                error = e.what();
+        }
+    }
+    if (!error.empty())
+        throw std::runtime_error("_BaseVE::_learnOnNestedSubsamples: Error while learning: " + error);
+
+    // Workers stop early when the call is cancelled
+    _stopIfCancelled(context, allResults, "_BaseVE::_learnOnNestedSubsamples");
+    return allResults;
+}
+
+// Helper function to validate a grid of subsample sizes
+std::vector<int> _BaseVE::_normalizeKGrid(std::vector<int> kGrid, long long n, const std::string &caller)
+{
+    if (kGrid.empty())
+        throw std::invalid_argument(caller + ": kGrid cannot be empty.");
+    std::sort(kGrid.begin(), kGrid.end());
+    kGrid.erase(std::unique(kGrid.begin(), kGrid.end()), kGrid.end());
+    if (kGrid.front() <= 0)
+        throw std::invalid_argument(caller + ": Subsample sizes in kGrid must be positive.");
+    if (kGrid.back() > n)
+        throw std::invalid_argument(caller + ": Subsample sizes in kGrid cannot exceed the sample size n = " +
+                                    std::to_string(n));
+    return kGrid;
+}
+
+// The solution selected for kGrid[kIndex] using the first B subsamples
+const Result &_BaseVE::SweepResult::selected(size_t kIndex, int B) const
+{
+    if (kIndex >= selectedByPrefix.size())
+        throw std::out_of_range("_BaseVE::SweepResult::selected: kIndex out of range");
+    if (B <= 0 || static_cast<size_t>(B) > selectedByPrefix[kIndex].size())
+        throw std::out_of_range("_BaseVE::SweepResult::selected: B out of range");
+    return candidates[kIndex][selectedByPrefix[kIndex][B - 1]];
+}
+
 // Helper function to launch parallel learners to learn on B subsamples.
 std::vector<std::future<std::vector<std::pair<int, std::variant<Result, int>>>>>
-_BaseVE::_launchLearningTasks(const Sample &sample, const std::vector<std::vector<int>> &subsampleIndices, int B)
+_BaseVE::_launchLearningTasks(_RunContext &context, const DataSource &data, long long n,
+                              const std::vector<std::vector<int>> &subsampleIndices, int B)
 {
-    int numWorkers = std::min(_numParallelLearn, B);
+    int numWorkers = _numWorkers(context, _numParallelLearn, B);
     std::vector<std::future<std::vector<std::pair<int, std::variant<Result, int>>>>> futures;
     futures.reserve(numWorkers);
 
@@ -125,15 +565,25 @@ _BaseVE::_launchLearningTasks(const Sample &sample, const std::vector<std::vecto
         std::vector<std::pair<int, std::variant<Result, int>>> workerResults;
         workerResults.reserve(endBatch - startBatch);
 
-        for (int b = startBatch; b < endBatch; ++b)
+        Gauge::Scope activeWorker(_LibraryMetrics::get().activeWorkers);
+        Sample buffer; // Reused by the subsamples of this worker
+        for (int b = startBatch; b < endBatch && !_isCancelled(context); ++b)
         {
             /**
              * Get the subsample indices
-             * Convert indices to Eigen::VectorXi
-             * Then, create a matrix by selecting rows from sample and learn on it
+             * Then, create a matrix by selecting rows from data and learn on it
              */
-            std::variant<Result, int> resultOrIndex = _processSingleSubsample(sample, subsampleIndices[b], b);
-            workerResults.emplace_back(b, std::move(resultOrIndex));
+            try
+            {
+                std::variant<Result, int> resultOrIndex = _processSingleSubsample(context, data, n, subsampleIndices[b], b, buffer);
+                workerResults.emplace_back(b, std::move(resultOrIndex));
+            }
+            catch (const OperationCancelled &)
+            { // A learner that polls the token of a cancelled call stops like the worker loop
+                if (!_isCancelled(context))
+                    throw;
+                break;
+            }
         }
         return workerResults;
     }; // End of taskLambda
@@ -148,8 +598,8 @@ _BaseVE::_launchLearningTasks(const Sample &sample, const std::vector<std::vecto
         int batchSize = tasksPerWorker + (i < remainingTasks ? 1 : 0); // Distribute remaining tasks
         int endIndex = startIndex + batchSize;
 
-        // Launch task asynchronously using std::async
-        futures.push_back(std::async(std::launch::async, taskLambda, i, startIndex, endIndex));
+        // Launch task asynchronously using std::async (a single worker runs on the calling thread)
+        futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, i, startIndex, endIndex));
 
         // Update startIndex for the next worker
         startIndex = endIndex;
@@ -166,21 +616,28 @@ std::vector<std::variant<Result, int>> _BaseVE::_collectResultsFromWorkers(
     std::vector<std::pair<int, std::variant<Result, int>>> allResults;
     allResults.reserve(B);
 
-    try
+    /**
+     * Wait for all workers before rethrowing, so that no worker still dumps results once the call unwinds
+     * (the results it already dumped are removed with the namespace directory of the call, see _beginRun).
+     */
+    std::string error;
+    for (auto &future : futures)
     {
-        for (auto &future : futures)
+        try
         {
             std::vector<std::pair<int, std::variant<Result, int>>> workerResults = future.get();
             allResults.insert(allResults.end(),
                               std::make_move_iterator(workerResults.begin()),
                               std::make_move_iterator(workerResults.end()));
         }
+        catch (const std::exception &e)
+        {
+            if (error.empty())
+                error = e.what();
+        }
     }
-    catch (const std::exception &e)
-    {
-        throw std::runtime_error("_BaseVE::_learnOnSubsamples: Error while collecting results: " +
-                                 std::string(e.what()));
-    }
+    if (!error.empty())
+        throw std::runtime_error("_BaseVE::_learnOnSubsamples: Error while collecting results: " + error);
 
     // Prepare for return, order the results by index
     std::vector<std::variant<Result, int>> allResultsToReturn(B);
@@ -193,19 +650,107 @@ std::vector<std::variant<Result, int>> _BaseVE::_collectResultsFromWorkers(
         }
         else
         {
-            std::cerr << "_BaseVE::_learnOnSubsamples: Warning: Received out-of-bounds index "
-                      << index << " for subsample result." << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Warning, "_BaseVE::_learnOnSubsamples: Received out-of-bounds index "
+                                                     << index << " for subsample result.");
         }
     }
     return allResultsToReturn;
 }
 
+// Helper function to group learning results by BaseLearner::isDuplicate
+_BaseVE::_DuplicateGroups _BaseVE::_groupDuplicateResults(_RunContext &context,
+                                                          const std::vector<std::variant<Result, int>> &learningResults)
+{
+    return _groupDuplicateResults(context, learningResults, 0, learningResults.size());
+}
+
+// Helper function to group count learning results starting at first
+_BaseVE::_DuplicateGroups _BaseVE::_groupDuplicateResults(_RunContext &context,
+                                                          const std::vector<std::variant<Result, int>> &learningResults,
+                                                          size_t first, size_t count)
+{
+    if (first + count > learningResults.size())
+        throw std::out_of_range("_BaseVE::_groupDuplicateResults: Range exceeds the learning results");
+
+    _DuplicateGroups groups;
+    groups.majorityIndexByPrefix.reserve(count);
+    int maxCount = 0;
+
+    /**
+     * The first unique candidates are copied as the columns of uniqueSet, so that each learning result is checked
+     * against all of them by a single call to BaseLearner::findDuplicate. The copies are bounded by
+     * MAX_UNIQUE_SET_BYTES, so that results held in external storage are not all brought back into memory.
+     * Later unique candidates, and learning results whose size differs from the copied ones, are compared one by
+     * one by isDuplicate, loading results in external storage for each comparison.
+     * Buffers are only filled when the candidates are held in external storage.
+     */
+    constexpr size_t MAX_UNIQUE_SET_BYTES = size_t(64) << 20;
+    Matrix uniqueSet;
+    size_t numCopied = 0; // The unique candidates 0, ..., numCopied - 1 are the first columns of uniqueSet
+    Result buffer1, buffer2, column;
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const Result &candidate1 = _loadResultIfNeeded(context, learningResults[i], buffer1);
+        if (candidate1.size() == 0)
+        { // Note that Result is essentially a vector
+            throw std::runtime_error("_BaseVE::_groupDuplicateResults: Empty candidate result at index " + std::to_string(i));
+        }
+
+        // Check if candidate1 agrees with any existing unique candidate
+        Eigen::Index duplicate = -1;
+        if (numCopied > 0 && candidate1.size() == uniqueSet.rows())
+        {
+            duplicate = _baseLearner->findDuplicate(candidate1, uniqueSet.leftCols(numCopied));
+        }
+        else
+        {
+            for (size_t j = 0; j < numCopied && duplicate < 0; ++j)
+            {
+                column = uniqueSet.col(j);
+                if (_baseLearner->isDuplicate(candidate1, column))
+                    duplicate = static_cast<Eigen::Index>(j);
+            }
+        }
+        for (size_t j = numCopied; j < groups.uniqueIndices.size() && duplicate < 0; ++j)
+        {
+            const Result &candidate2 = _loadResultIfNeeded(context, learningResults[groups.uniqueIndices[j]], buffer2);
+            if (_baseLearner->isDuplicate(candidate1, candidate2))
+                duplicate = static_cast<Eigen::Index>(j);
+        }
+        size_t group = duplicate >= 0 ? static_cast<size_t>(duplicate) : groups.uniqueIndices.size();
+
+        if (group == groups.uniqueIndices.size())
+        { // No match found, add a new unique candidate
+            size_t maxCopies = MAX_UNIQUE_SET_BYTES / (static_cast<size_t>(candidate1.size()) * sizeof(double));
+            if (numCopied == groups.uniqueIndices.size() && numCopied < maxCopies &&
+                (numCopied == 0 || candidate1.size() == uniqueSet.rows()))
+            { // Copy it while all unique candidates so far are copied, have its size and fit the bound
+                if (numCopied == static_cast<size_t>(uniqueSet.cols()))
+                    uniqueSet.conservativeResize(candidate1.size(), std::min(std::max<size_t>(4, 2 * numCopied), maxCopies));
+                uniqueSet.col(numCopied++) = candidate1;
+            }
+            groups.uniqueIndices.push_back(i);
+            groups.counts.push_back(0);
+        }
+        groups.counts[group]++;
+
+        // Update the most frequent candidate
+        if (groups.counts[group] > maxCount)
+        {
+            maxCount = groups.counts[group];
+            groups.majorityIndex = group;
+        }
+        groups.majorityIndexByPrefix.push_back(groups.majorityIndex);
+    }
+    return groups;
+}
+
 // Helper function to clean up the subsample results if external storage is enabled
-void _BaseVE::_cleanupSubsampleResults(const std::vector<std::variant<Result, int>> &learningResults)
+void _BaseVE::_cleanupSubsampleResults(_RunContext &context, const std::vector<std::variant<Result, int>> &learningResults)
 {
     if (_deleteSubsampleResults &&
-        _subsampleResultIO &&
-        _subsampleResultIO->isExternalStorateEnabled())
+        context.subsampleResultIO &&
+        context.subsampleResultIO->isExternalStorateEnabled())
     {
 
         std::vector<int> indicesToDelete;
@@ -225,31 +770,38 @@ void _BaseVE::_cleanupSubsampleResults(const std::vector<std::variant<Result, in
 
         if (!indicesToDelete.empty())
         {
-            _subsampleResultIO->_deleteSubsampleResult(indicesToDelete);
+            context.subsampleResultIO->_deleteSubsampleResult(indicesToDelete);
         }
     }
 }
 
 // Main learning method
-std::vector<std::variant<Result, int>> _BaseVE::_learnOnSubsamples(const Sample &sample, int k, int B)
+std::vector<std::variant<Result, int>> _BaseVE::_learnOnSubsamples(_RunContext &context, const DataSource &data,
+                                                                  long long n, int k, int B)
 {
     if (B <= 0)
         throw std::invalid_argument("_BaseVE::_learnOnSubsamples: Number of subsamples B must be positive.");
 
-    long long n = sample.rows();
+    if (n > data.rows())
+        throw std::invalid_argument("_BaseVE::_learnOnSubsamples: n cannot exceed the number of rows of data.");
     if (n < k)
         throw std::invalid_argument("_BaseVE::_learnOnSubsamples: Sample size n must be greater than or equal to k.");
     else if (k <= 0)
         throw std::invalid_argument("_BaseVE::_learnOnSubsamples: Subsample size k must be positive.");
 
     // Generate B sets of subsample indices, each of size k.
-    std::vector<std::vector<int>> subsampleIndices = _generateSubsampleIndices(n, k, B);
+    std::vector<std::vector<int>> subsampleIndices = _generateSubsampleIndices(context, n, k, B);
+
+    // Make room for B results in external storage (only needed by the fixed-stride layout)
+    context.subsampleResultIO->_prepareSlots(B);
 
     // Launch parallel learners to learn on B subsamples.
-    auto futures = _launchLearningTasks(sample, subsampleIndices, B);
+    auto futures = _launchLearningTasks(context, data, n, subsampleIndices, B);
 
-    // Collect results from futures and order them by index.
-    return _collectResultsFromWorkers(futures, B);
+    // Collect results from futures and order them by index (workers stop early when the call is cancelled)
+    std::vector<std::variant<Result, int>> learningResults = _collectResultsFromWorkers(futures, B);
+    _stopIfCancelled(context, learningResults, "_BaseVE::_learnOnSubsamples");
+    return learningResults;
 }
 
 // Pure virtual base method, cannot be called directly
@@ -1,6 +1,8 @@
 #include "BaseLearner.hpp"
 #include "_CachedEvaluator.hpp"
 #include "_SubsampleResultIO.hpp"
+#include "ThreadConfig.hpp"
+#include "Metrics.hpp"
 #include "types.hpp"
 
 #include <vector>
@@ -11,19 +13,27 @@
 #include <future>     // For std::async, std::future
 #include <set>        // For std::set to find unique indices
 #include <iostream>   // For std::cerr
+#include <cmath>      // For std::pow
+#include <numeric>    // For std::iota
 #include <Eigen/Core> // Include Eigen Core for Map and VectorXi (if not implicitly included)
 
 // Constructor
 _CachedEvaluator::_CachedEvaluator(BaseLearner *baseLearner,
                                    _SubsampleResultIO *subsampleResultIO,
                                    const std::vector<std::variant<Result, int>> &subsampleResultList,
-                                   const Sample &sample,
-                                   int numParallelLearn)
+                                   std::vector<size_t> candidateIndices,
+                                   const DataSource &data,
+                                   int numParallelLearn,
+                                   const CancellationToken *cancellation,
+                                   EvaluationMemo *memo)
     : _baseLearner(baseLearner),
       _subsampleResultIO(subsampleResultIO),
       _subsampleResultList(subsampleResultList),
-      _sample(sample),
-      _numParallelLearn(std::max(1, numParallelLearn))
+      _candidateIndices(std::move(candidateIndices)),
+      _data(data),
+      _numParallelLearn(std::max(1, numParallelLearn)),
+      _cancellation(cancellation),
+      _memo(memo)
 {
     if (!_baseLearner)
         throw std::invalid_argument("_CachedEvaluator constructor: baseLearner cannot be null");
@@ -31,31 +41,43 @@ _CachedEvaluator::_CachedEvaluator(BaseLearner *baseLearner,
         throw std::invalid_argument("_CachedEvaluator constructor: subsampleResultIO cannot be null");
     if (_subsampleResultList.empty())
         throw std::invalid_argument("_CachedEvaluator constructor: subsampleResultList cannot be empty");
-    if (_sample.rows() == 0)
+    if (_candidateIndices.empty())
+        throw std::invalid_argument("_CachedEvaluator constructor: candidateIndices cannot be empty");
+    for (size_t index : _candidateIndices)
+    {
+        if (index >= _subsampleResultList.size())
+            throw std::out_of_range("_CachedEvaluator constructor: candidate index out of range");
+    }
+    if (_data.rows() == 0)
         throw std::invalid_argument("_CachedEvaluator constructor: sample cannot be empty");
+
+    _candidatesToEvaluate.resize(_candidateIndices.size());
+    std::iota(_candidatesToEvaluate.begin(), _candidatesToEvaluate.end(), 0);
 }
 
 // Helper function used to load a specific solution from the storage.
-Result _CachedEvaluator::_loadCandidate(size_t candidateIndex) const
+const Result &_CachedEvaluator::_loadCandidate(size_t candidateIndex, Result &buffer) const
 {
-    if (candidateIndex >= _subsampleResultList.size() || candidateIndex < 0)
+    if (candidateIndex >= _candidateIndices.size())
         throw std::out_of_range("_CachedEvaluator::_loadCandidate: candidateIndex out of range");
 
     /**
      * candidate is either Result or int
      * If expressed as an index, candidate is the index for the storage (not the index in the vector candidateIndex)
      */
-    const auto &candidate = _subsampleResultList[candidateIndex];
+    const auto &candidate = _subsampleResultList[_candidateIndices[candidateIndex]];
     if (std::holds_alternative<Result>(candidate))
         return std::get<Result>(candidate);
-    else
-        return _subsampleResultIO->_loadSubsampleResult(std::get<int>(candidate));
+
+    _subsampleResultIO->_loadSubsampleResult(std::get<int>(candidate), buffer);
+    return buffer;
 }
 
 // Helper function to generate B sets of subsample indices, each of size k.
 std::pair<std::vector<std::vector<int>>, std::vector<int>>
 _CachedEvaluator::_generateEvaluationSampleIndices(const std::vector<int> &sampleIndexList,
-                                                   int B, int k, std::mt19937 &rng)
+                                                   int B, int k, std::mt19937 &rng,
+                                                   int blockSize, bool collectUniqueSamples)
 {
     size_t n = sampleIndexList.size();
     std::set<int> sampleToEvaluateSet;
@@ -64,15 +86,31 @@ _CachedEvaluator::_generateEvaluationSampleIndices(const std::vector<int> &sampl
     // Fill the subsample indices and record the unique samples
     for (int b = 0; b < B; ++b)
     {
-        subsampleIndices[b].reserve(k);
-        // Sample k indices from sampleIndexList
-        std::sample(sampleIndexList.begin(), sampleIndexList.end(), std::back_inserter(subsampleIndices[b]), k, rng);
+        if (blockSize > 1)
+        {
+            // Sample k entries of sampleIndexList as random blocks, in the order of sampleIndexList
+            std::vector<int> positions = _sampleBlockPositions(static_cast<int>(n), k, blockSize, rng);
+            std::sort(positions.begin(), positions.end());
+            subsampleIndices[b].resize(k);
+            for (int i = 0; i < k; ++i)
+                subsampleIndices[b][i] = sampleIndexList[positions[i]];
+        }
+        else
+        {
+            subsampleIndices[b].reserve(k);
+            // Sample k indices from sampleIndexList
+            std::sample(sampleIndexList.begin(), sampleIndexList.end(), std::back_inserter(subsampleIndices[b]), k, rng);
+        }
 
+        if (!collectUniqueSamples)
+            continue; // The full-scan mode evaluates all samples, so the unique samples are not needed
         for (int sampleIndex : subsampleIndices[b])
         {
             sampleToEvaluateSet.insert(sampleIndex);
         }
     }
+    if (!collectUniqueSamples)
+        return {subsampleIndices, {}};
 
     // Convert set to vector (of indices) for convenience
     std::vector<int> sampleToEvaluate(sampleToEvaluateSet.begin(), sampleToEvaluateSet.end());
@@ -86,21 +124,30 @@ _CachedEvaluator::_generateEvaluationSampleIndices(const std::vector<int> &sampl
 Matrix _CachedEvaluator::_evaluateCandidatesOnSamples(const std::vector<int> &uniqueSampleIndices)
 {
     size_t numSamplesAssigned = uniqueSampleIndices.size();
-    size_t numCandidates = _subsampleResultList.size();
+    size_t numCandidates = _candidateIndices.size();
     if (numSamplesAssigned == 0)
         throw std::invalid_argument("_CachedEvaluator::_evaluateCandidatesOnSamples: No samples to evaluate on.");
     if (numCandidates == 0)
         throw std::invalid_argument("_CachedEvaluator::_evaluateCandidatesOnSamples: No candidates to evaluate on.");
 
     Matrix workerResults(numSamplesAssigned, numCandidates);
-    Eigen::Map<const Eigen::VectorXi> workerSampleIndicesMap(uniqueSampleIndices.data(), uniqueSampleIndices.size());
-    Sample workerSampleData = _sample(workerSampleIndicesMap, Eigen::all); // Create a matrix by selecting rows from sample
+    Sample workerSampleData; // Create a matrix by selecting rows from data
+    _data.gatherRows(uniqueSampleIndices.data(), static_cast<Eigen::Index>(uniqueSampleIndices.size()), workerSampleData);
 
-    // Evaluate all candidates on the assigned samples
-    for (size_t c = 0; c < numCandidates; ++c)
+    // Evaluate the candidates on the assigned samples (the columns of memoized candidates are filled later)
+    Result buffer; // Only used for candidates in external storage
+    _LibraryMetrics &metrics = _LibraryMetrics::get();
+    Gauge::Scope activeWorker(metrics.activeWorkers);
+    metrics.evaluationRows.add(numSamplesAssigned);
+    for (size_t i = 0; i < _candidatesToEvaluate.size() && !_isCancelled(); ++i)
     {
-        Result candidate = _loadCandidate(c);
-        Vector evalResult = _baseLearner->objective(candidate, workerSampleData);
+        size_t c = _candidatesToEvaluate[i];
+        const Result &candidate = _loadCandidate(c, buffer);
+        Vector evalResult;
+        {
+            Histogram::Timer timer(metrics.objectiveSeconds);
+            evalResult = _baseLearner->objective(candidate, workerSampleData);
+        }
         // Sanity check the size of evalResult
         if (evalResult.size() != static_cast<Eigen::Index>(numSamplesAssigned))
         {
@@ -112,6 +159,96 @@ Matrix _CachedEvaluator::_evaluateCandidatesOnSamples(const std::vector<int> &un
     return workerResults;
 }
 
+// Helper function to check whether cancellation was requested
+bool _CachedEvaluator::_isCancelled() const
+{
+    return _cancellation && _cancellation->isCancelled();
+}
+
+// Helper function to set the candidates to evaluate on rows
+void _CachedEvaluator::_selectCandidatesToEvaluate(const std::vector<int> &rows)
+{
+    if (!_memo)
+        return; // All candidates, as set by the constructor
+
+    size_t numCandidates = _candidateIndices.size();
+    if (_memoColumns.empty())
+    {
+        std::uint64_t fingerprint = EvaluationMemo::fingerprint(_data);
+        Result buffer; // Only used for candidates in external storage
+        _memoColumns.reserve(numCandidates);
+        for (size_t c = 0; c < numCandidates; ++c)
+        {
+            std::uint64_t candidateHash = EvaluationMemo::candidateHash(*_baseLearner, _loadCandidate(c, buffer));
+            _memoColumns.push_back(&_memo->column(fingerprint, candidateHash, _data.rows()));
+        }
+    }
+
+    _candidatesToEvaluate.clear();
+    for (size_t c = 0; c < numCandidates; ++c)
+    {
+        if (!_memo->contains(*_memoColumns[c], rows))
+            _candidatesToEvaluate.push_back(c);
+    }
+}
+
+// Helper function to complete an evaluation with the memo
+void _CachedEvaluator::_exchangeWithMemo(const std::vector<int> &rows, bool fullScan)
+{
+    if (!_memo)
+        return;
+
+    size_t numCandidates = _candidateIndices.size();
+    std::vector<bool> evaluated(numCandidates, false);
+    for (size_t c : _candidatesToEvaluate)
+        evaluated[c] = true;
+
+    // Column c of values holds the objective values of the c-th candidate on rows
+    Matrix values(rows.size(), numCandidates);
+    for (size_t c = 0; c < numCandidates; ++c)
+    {
+        if (!evaluated[c])
+            _memo->read(*_memoColumns[c], rows, values.col(c).data());
+    }
+
+    // Swap values with the cache row by row: memoized values in, computed values out
+    auto exchangeRow = [&](size_t i, auto &&cachedRow)
+    {
+        for (size_t c = 0; c < numCandidates; ++c)
+        {
+            if (evaluated[c])
+                values(i, c) = cachedRow(c);
+            else
+                cachedRow(c) = values(i, c);
+        }
+    };
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (fullScan)
+        {
+            exchangeRow(i, _denseCache.row(static_cast<Eigen::Index>(i)));
+        }
+        else
+        {
+            RowVector &cachedRow = _cachedEvaluation[rows[i]];
+            if (cachedRow.size() != static_cast<Eigen::Index>(numCandidates)) // Not evaluated, all candidates are memoized
+                cachedRow.resize(numCandidates);
+            exchangeRow(i, cachedRow);
+        }
+    }
+
+    for (size_t c : _candidatesToEvaluate)
+        _memo->write(*_memoColumns[c], rows, values.col(c).data());
+    _LibraryMetrics::get().evaluationMemoHits.add(numCandidates - _candidatesToEvaluate.size());
+}
+
+// Helper function to record the subsample rows served by the cache
+void _CachedEvaluator::_recordCacheHits(long long subsampleRows, long long evaluatedRows)
+{
+    if (subsampleRows > evaluatedRows)
+        _LibraryMetrics::get().evaluationCacheHits.add(static_cast<std::uint64_t>(subsampleRows - evaluatedRows));
+}
+
 // Helper function to get cached evaluation results in parallel.
 void _CachedEvaluator::_getCachedEvaluation(const std::vector<int> &sampleToEvaluate)
 {
@@ -155,7 +292,7 @@ void _CachedEvaluator::_getCachedEvaluation(const std::vector<int> &sampleToEval
          * Launch task asynchronously using std::async
          * Note that we use std::cref to pass the vector by reference
          */
-        futures.push_back(std::async(std::launch::async, taskLambda, std::cref(allWorkerSampleIndices[i])));
+        futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, std::cref(allWorkerSampleIndices[i])));
         startIndex = endIndex;
     }
 
@@ -187,10 +324,258 @@ void _CachedEvaluator::_getCachedEvaluation(const std::vector<int> &sampleToEval
     }
 }
 
+// Helper function to decide whether to use the full-scan mode
+bool _CachedEvaluator::_useFullScan(const std::vector<int> &sampleIndexList, int B, int k)
+{
+    // The rows must be contiguous, so that they can be read sequentially without gathering
+    for (size_t i = 1; i < sampleIndexList.size(); ++i)
+    {
+        if (sampleIndexList[i] != sampleIndexList[0] + static_cast<int>(i))
+            return false;
+    }
+
+    return _coversMostRows(static_cast<long long>(sampleIndexList.size()), B, k);
+}
+
+// Expected coverage of B subsamples of size k drawn from numRows rows
+bool _CachedEvaluator::_coversMostRows(long long numRows, int B, int k)
+{
+    if (numRows <= 0)
+        return false;
+    double n = static_cast<double>(numRows);
+    double expectedCoverage = 1.0 - std::pow(1.0 - static_cast<double>(k) / n, static_cast<double>(B));
+    return expectedCoverage >= FULL_SCAN_MIN_COVERAGE;
+}
+
+// Helper function used by the full-scan mode
+void _CachedEvaluator::_getFullScanEvaluation(long long start, long long numRows)
+{
+    size_t numCandidates = _candidateIndices.size();
+    _denseCache.resize(numRows, numCandidates);
+    _denseCacheStart = start;
+    if (_candidatesToEvaluate.empty())
+        return; // All candidates are memoized
+
+    int numWorkers = static_cast<int>(std::min(static_cast<long long>(_numParallelLearn), numRows));
+
+    /**
+     * The following lambda function is used to evaluate all candidates on the rows [rowBegin, rowEnd)
+     * (relative to start). The rows are processed in chunks, each chunk is read from the sample once
+     * (a sequential copy, since BaseLearner::objective takes a Sample) and evaluated for all candidates.
+     * Workers write disjoint rows of _denseCache, so no synchronization is needed.
+     */
+    auto taskLambda = [&](long long rowBegin, long long rowEnd)
+    {
+        Result buffer; // Only used for candidates in external storage
+        Sample chunk;
+        _LibraryMetrics &metrics = _LibraryMetrics::get();
+        Gauge::Scope activeWorker(metrics.activeWorkers);
+        for (long long chunkBegin = rowBegin; chunkBegin < rowEnd && !_isCancelled(); chunkBegin += FULL_SCAN_CHUNK_ROWS)
+        {
+            long long chunkRows = std::min(FULL_SCAN_CHUNK_ROWS, rowEnd - chunkBegin);
+            _data.copyRows(start + chunkBegin, chunkRows, chunk);
+            metrics.evaluationRows.add(chunkRows);
+            for (size_t c : _candidatesToEvaluate)
+            {
+                const Result &candidate = _loadCandidate(c, buffer);
+                Vector evalResult;
+                {
+                    Histogram::Timer timer(metrics.objectiveSeconds);
+                    evalResult = _baseLearner->objective(candidate, chunk);
+                }
+                if (evalResult.size() != chunkRows)
+                {
+                    throw std::runtime_error("BaseLearner::objective returned unexpected size. Expected " + std::to_string(chunkRows) +
+                                             ", got " + std::to_string(evalResult.size()) + ".");
+                }
+                _denseCache.block(chunkBegin, c, chunkRows, 1) = evalResult;
+            }
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(numWorkers);
+    long long rowsPerWorker = numRows / numWorkers;
+    long long remainingRows = numRows % numWorkers;
+    long long rowBegin = 0;
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        long long rowEnd = rowBegin + rowsPerWorker + (i < remainingRows ? 1 : 0);
+        futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, rowBegin, rowEnd));
+        rowBegin = rowEnd;
+    }
+
+    try
+    {
+        for (auto &future : futures)
+            future.get();
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error("_CachedEvaluator::_getFullScanEvaluation: Error while collecting parallel results: " +
+                                 std::string(e.what()));
+    }
+}
+
+// Helper function to compute the subsample means, used by the linear-objective mode
+Matrix _CachedEvaluator::_subsampleMeans(const std::vector<std::vector<int>> &subsampleIndices,
+                                         const std::vector<int> &rows, bool contiguous)
+{
+    Eigen::Index B = static_cast<Eigen::Index>(subsampleIndices.size());
+    Matrix sums = Matrix::Zero(B, _data.cols());
+    std::vector<std::future<void>> futures;
+    auto waitForWorkers = [&futures]()
+    {
+        try
+        {
+            for (auto &future : futures)
+                future.get();
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error("_CachedEvaluator::_subsampleMeans: Error while collecting parallel results: " +
+                                     std::string(e.what()));
+        }
+    };
+
+    if (contiguous)
+    {
+        /**
+         * Stream the range in chunks of FULL_SCAN_CHUNK_ROWS, as the full-scan mode does, so that the rows are
+         * never all held in memory. The subsamples that contain the i-th row of the range (with repetition) are
+         * memberships[offsets[i], offsets[i + 1]), so each row of a chunk is added to the sums of its subsamples.
+         */
+        long long first = rows.front();
+        long long numRows = static_cast<long long>(rows.size());
+        std::vector<size_t> offsets(numRows + 1, 0);
+        for (const std::vector<int> &indices : subsampleIndices)
+        {
+            for (int sampleIndex : indices)
+                ++offsets[sampleIndex - first + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<int> memberships(offsets.back());
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (int b = 0; b < static_cast<int>(B); ++b)
+        {
+            for (int sampleIndex : subsampleIndices[b])
+                memberships[next[sampleIndex - first]++] = b;
+        }
+
+        // Each worker streams a contiguous block of rows into its own sums, which are added at the end
+        int numWorkers = static_cast<int>(std::min(static_cast<long long>(_numParallelLearn), numRows));
+        std::vector<Matrix> workerSums(numWorkers, Matrix::Zero(B, _data.cols()));
+        auto taskLambda = [&](int worker, long long rowBegin, long long rowEnd)
+        {
+            Gauge::Scope activeWorker(_LibraryMetrics::get().activeWorkers);
+            Matrix &workerSum = workerSums[worker];
+            Sample chunk;
+            for (long long chunkBegin = rowBegin; chunkBegin < rowEnd && !_isCancelled(); chunkBegin += FULL_SCAN_CHUNK_ROWS)
+            {
+                long long chunkRows = std::min(FULL_SCAN_CHUNK_ROWS, rowEnd - chunkBegin);
+                _data.copyRows(first + chunkBegin, chunkRows, chunk);
+                for (long long r = 0; r < chunkRows; ++r)
+                {
+                    for (size_t m = offsets[chunkBegin + r]; m < offsets[chunkBegin + r + 1]; ++m)
+                        workerSum.row(memberships[m]) += chunk.row(r);
+                }
+            }
+        };
+
+        futures.reserve(numWorkers);
+        long long rowsPerWorker = numRows / numWorkers;
+        long long remainingRows = numRows % numWorkers;
+        long long rowBegin = 0;
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            long long rowEnd = rowBegin + rowsPerWorker + (i < remainingRows ? 1 : 0);
+            futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, i, rowBegin, rowEnd));
+            rowBegin = rowEnd;
+        }
+        waitForWorkers();
+        for (const Matrix &workerSum : workerSums)
+            sums += workerSum;
+    }
+    else
+    {
+        /**
+         * Gather the (sorted, unique) rows once, the analogue of the (numRows, num_candidates) dense cache.
+         * Workers handle disjoint blocks of subsamples, and find each row by binary search.
+         */
+        Sample rowData;
+        _data.gatherRows(rows.data(), static_cast<Eigen::Index>(rows.size()), rowData);
+        auto taskLambda = [&](Eigen::Index bBegin, Eigen::Index bEnd)
+        {
+            Gauge::Scope activeWorker(_LibraryMetrics::get().activeWorkers);
+            for (Eigen::Index b = bBegin; b < bEnd; ++b)
+            {
+                RowVector sum = RowVector::Zero(_data.cols());
+                for (int sampleIndex : subsampleIndices[b])
+                    sum += rowData.row(std::lower_bound(rows.begin(), rows.end(), sampleIndex) - rows.begin());
+                sums.row(b) = sum;
+            }
+        };
+
+        int numWorkers = static_cast<int>(std::min(static_cast<Eigen::Index>(_numParallelLearn), B));
+        futures.reserve(numWorkers);
+        Eigen::Index subsamplesPerWorker = B / numWorkers;
+        Eigen::Index remainingSubsamples = B % numWorkers;
+        Eigen::Index bBegin = 0;
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            Eigen::Index bEnd = bBegin + subsamplesPerWorker + (i < remainingSubsamples ? 1 : 0);
+            futures.push_back(std::async(launchPolicyFor(numWorkers), taskLambda, bBegin, bEnd));
+            bBegin = bEnd;
+        }
+        waitForWorkers();
+    }
+
+    // Apply the 1 / k of the averaging matrix
+    for (Eigen::Index b = 0; b < B; ++b)
+        sums.row(b) /= static_cast<double>(subsampleIndices[b].size());
+    return sums;
+}
+
+// Helper function to collect the candidates as the columns of a matrix, used by the linear-objective mode
+Matrix _CachedEvaluator::_candidateMatrix() const
+{
+    size_t numCandidates = _candidateIndices.size();
+    Matrix candidates(_data.cols(), numCandidates);
+    Result buffer; // Only used for candidates in external storage
+    for (size_t c = 0; c < numCandidates; ++c)
+    {
+        const Result &candidate = _loadCandidate(c, buffer);
+        if (candidate.size() != _data.cols())
+        {
+            throw std::runtime_error("_CachedEvaluator::_candidateMatrix: A linear objective requires candidates of size " +
+                                     std::to_string(_data.cols()) + ", got " + std::to_string(candidate.size()) + ".");
+        }
+        candidates.col(c) = candidate;
+    }
+    return candidates;
+}
+
+// Helper function to add the cached evaluation results of a sample to sum
+bool _CachedEvaluator::_addCachedEvaluation(int sampleIndex, RowVector &sum) const
+{
+    long long denseIndex = static_cast<long long>(sampleIndex) - _denseCacheStart;
+    if (denseIndex >= 0 && denseIndex < _denseCache.rows())
+    {
+        sum += _denseCache.row(denseIndex);
+        return true;
+    }
+
+    auto it = _cachedEvaluation.find(sampleIndex);
+    if (it == _cachedEvaluation.end())
+        return false;
+    sum += it->second;
+    return true;
+}
+
 // Helper function to compute the final evaluation results on subsamples.
 Matrix _CachedEvaluator::_getFinalEvaluationResults(const std::vector<std::vector<int>> &subsampleIndices, int B)
 {
-    size_t numCandidates = _subsampleResultList.size();
+    size_t numCandidates = _candidateIndices.size();
     Matrix evalResultsToReturn(B, numCandidates);
     evalResultsToReturn.setZero();
     for (int b = 0; b < B; ++b)
@@ -202,10 +587,8 @@ Matrix _CachedEvaluator::_getFinalEvaluationResults(const std::vector<std::vecto
 
         for (int sampleIndex : sampleIndicesToSum)
         {
-            auto it = _cachedEvaluation.find(sampleIndex);
-            if (it != _cachedEvaluation.end())
+            if (_addCachedEvaluation(sampleIndex, sumResultsForBatch)) // Add the evaluation result for this sample
             {
-                sumResultsForBatch += it->second; // Add the evaluation result for this sample
                 ++subsampleSize;
             }
             else
@@ -231,7 +614,8 @@ Matrix _CachedEvaluator::_getFinalEvaluationResults(const std::vector<std::vecto
 }
 
 // Main evaluation method
-Matrix _CachedEvaluator::_evaluateSubsamples(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng)
+Matrix _CachedEvaluator::_evaluateSubsamples(const std::vector<int> &sampleIndexList, int B, int k, std::mt19937 &rng,
+                                             int blockSize)
 {
     if (B <= 0)
         throw std::invalid_argument("_CachedEvaluator::_evaluateSubsamples: Number of subsamples B must be positive.");
@@ -239,16 +623,56 @@ Matrix _CachedEvaluator::_evaluateSubsamples(const std::vector<int> &sampleIndex
     if (n < k || k <= 0)
         throw std::invalid_argument("_CachedEvaluator::_evaluateSubsamples: Sample size n must be greater than or equal to k and k must be positive.");
 
+    /**
+     * Linear-objective mode: the mean objective of a candidate on a subsample is the mean row of the subsample
+     * times the candidate. So the evaluation matrix is the product of the (B, d) subsample means, computed
+     * in one pass over the rows (the whole range in the full-scan case, the unique samples otherwise), and
+     * the (d, num_candidates) candidates. The subsamples are drawn exactly as in the other modes.
+     */
+    if (_baseLearner->isLinearObjective())
+    {
+        bool fullScan = _useFullScan(sampleIndexList, B, k);
+        auto [subsampleIndices, sampleToEvaluate] =
+            _generateEvaluationSampleIndices(sampleIndexList, B, k, rng, blockSize, !fullScan);
+        Matrix means = fullScan ? _subsampleMeans(subsampleIndices, sampleIndexList, true)
+                                : _subsampleMeans(subsampleIndices, sampleToEvaluate, false);
+        if (_isCancelled())
+            _cancellation->throwIfCancelled("_CachedEvaluator::_evaluateSubsamples");
+        return means * _candidateMatrix();
+    }
+
+    /**
+     * Full-scan mode: the subsamples cover most of a contiguous range of rows, so evaluate all candidates
+     * on the whole range in a sequential pass. This skips collecting the unique samples and gathering them.
+     */
+    if (_useFullScan(sampleIndexList, B, k))
+    {
+        auto [subsampleIndices, unused] = _generateEvaluationSampleIndices(sampleIndexList, B, k, rng, blockSize, false);
+        _selectCandidatesToEvaluate(sampleIndexList);
+        _getFullScanEvaluation(sampleIndexList.front(), static_cast<long long>(n));
+        if (_isCancelled()) // The workers stopped early, so the dense cache is incomplete
+            _cancellation->throwIfCancelled("_CachedEvaluator::_evaluateSubsamples");
+        _exchangeWithMemo(sampleIndexList, true);
+        _recordCacheHits(static_cast<long long>(B) * k, static_cast<long long>(n));
+        return _getFinalEvaluationResults(subsampleIndices, B);
+    }
+
     /**
      * Generate B sets of subsample indices, each of size k.
      * subsampleIndices stores B sets of subsample indices
      * sampleToEvaluate stores the unique sample indices to be evaluated on
      * (_generateEvaluationSampleIndices automatically checks whether sampleIndexList is empty)
      */
-    auto [subsampleIndices, sampleToEvaluate] = _generateEvaluationSampleIndices(sampleIndexList, B, k, rng);
+    auto [subsampleIndices, sampleToEvaluate] = _generateEvaluationSampleIndices(sampleIndexList, B, k, rng, blockSize);
 
-    // Get cached evaluation results in parallel, store them in _cachedEvaluation
-    _getCachedEvaluation(sampleToEvaluate);
+    // Get cached evaluation results in parallel (of the candidates that are not memoized), store them in _cachedEvaluation
+    _selectCandidatesToEvaluate(sampleToEvaluate);
+    if (!_candidatesToEvaluate.empty())
+        _getCachedEvaluation(sampleToEvaluate);
+    if (_isCancelled()) // The workers stopped early, so the cache is incomplete
+        _cancellation->throwIfCancelled("_CachedEvaluator::_evaluateSubsamples");
+    _exchangeWithMemo(sampleToEvaluate, false);
+    _recordCacheHits(static_cast<long long>(B) * k, static_cast<long long>(sampleToEvaluate.size()));
 
     // Compute the final result using cache
     return _getFinalEvaluationResults(subsampleIndices, B);
@@ -1,16 +1,77 @@
 #include "BaseLearner.hpp"
 #include "_SubsampleResultIO.hpp"
+#include "Metrics.hpp"
+#include "Logger.hpp"
 #include "types.hpp"
 
 #include <vector>
 #include <zstd.h>     // For ZSTD compression and decompression
 #include <filesystem> // For path operations, create_directories, remove
-#include <fstream>    // For std::ofstream, std::ifstream
 #include <sstream>    // For std::stringstream (memory buffer)
-#include <iostream>   // For std::cerr (error reporting)
 #include <stdexcept>  // For std::runtime_error, std::invalid_argument
-#include <iostream>   // For potential debug/error messages (optional)
 #include <string>     // For std::to_string
+#include <random>     // For std::random_device, std::mt19937_64
+#include <chrono>     // For mixing the time into the namespace name
+#include <atomic>     // For the process-wide namespace counter
+#include <thread>     // For std::this_thread::get_id
+#include <sstream>    // For std::ostringstream (hex formatting)
+#include <system_error> // For std::error_code
+#include <cstring>    // For std::memcpy, std::memset
+#include <cstdlib>    // For std::aligned_alloc, std::free
+#include <algorithm>  // For std::max
+#include <new>        // For std::bad_alloc
+#include <cerrno>     // For errno
+#include <fcntl.h>    // For open, posix_fadvise, O_DIRECT
+#include <unistd.h>   // For ftruncate, close, read, write
+#include <sys/mman.h> // For mmap, munmap, madvise
+#include <sys/stat.h> // For fstat
+
+namespace
+{
+    // File name of the fixed-stride layout inside the namespace directory
+    const char *FIXED_STRIDE_FILE_NAME = "subsampleResults.bin";
+
+    // Alignment of the buffers, file offsets and transfer sizes of O_DIRECT (the logical block size of most devices)
+    constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    size_t alignUp(size_t bytes)
+    {
+        return (bytes + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    }
+
+    // write and read until size bytes are transferred (or the end of the file), retrying interrupted calls
+    bool writeAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    ssize_t readAll(int fd, char *data, size_t size)
+    {
+        size_t total = 0;
+        while (total < size)
+        {
+            ssize_t got = ::read(fd, data + total, size - total);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0)
+                return -1;
+            if (got == 0)
+                break;
+            total += static_cast<size_t>(got);
+        }
+        return static_cast<ssize_t>(total);
+    }
+}
 
 // Helper function to convert optional string to optional path
 std::optional<std::filesystem::path> stringToPathOpt(const std::optional<std::string> &strOpt)
@@ -32,32 +93,207 @@ std::optional<std::filesystem::path> stringToPathOpt(const std::optional<std::st
 
 // Constructor
 _SubsampleResultIO::_SubsampleResultIO(BaseLearner *baseLearner,
-                                       const std::optional<std::string> &subsampleResultsDir)
-    : _baseLearner(baseLearner), _resultDir(stringToPathOpt(subsampleResultsDir))
+                                       const std::optional<std::string> &subsampleResultsDir,
+                                       StorageLayout layout,
+                                       bool directIO)
+    : _baseLearner(baseLearner), _resultDir(stringToPathOpt(subsampleResultsDir)), _layout(layout), _directIO(directIO)
 {
     if (!_baseLearner)
         throw std::invalid_argument("_SubsampleResultIO constructor: baseLearner cannot be null");
 }
 
+// Destructor, removes the namespace directory if it is empty
+_SubsampleResultIO::~_SubsampleResultIO()
+{
+    if (_removeRunDir && _runDir)
+    {
+        // The results are not kept, so the directory goes with everything in it. Errors are ignored.
+        _unmapSlots();
+        if (_fd >= 0)
+            ::close(_fd);
+        std::error_code ec;
+        std::filesystem::remove_all(*_runDir, ec);
+        return;
+    }
+    if (_mapping)
+    {
+        // Remove the fixed-stride file if all slots are empty, i.e., all results have been deleted
+        bool allEmpty = true;
+        for (int i = 0; i < _numSlots && allEmpty; ++i)
+        {
+            std::uint64_t header;
+            std::memcpy(&header, _mapping + i * _slotBytes(), sizeof(header));
+            allEmpty = (header == 0);
+        }
+        _unmapSlots();
+        if (allEmpty)
+        {
+            std::error_code ec;
+            std::filesystem::remove(*_runDir / FIXED_STRIDE_FILE_NAME, ec);
+        }
+    }
+    if (_fd >= 0)
+        ::close(_fd);
+    if (_runDir)
+    {
+        // remove() only deletes empty directories, so kept results are never lost. Errors are ignored.
+        std::error_code ec;
+        std::filesystem::remove(*_runDir, ec);
+    }
+}
+
 // Join the directory with the index
 std::filesystem::path _SubsampleResultIO::_subsampleResultPath(const std::filesystem::path &dir, int index)
 {
-    // create files look like "resultsDir/subsampleResult_0"
+    // create files look like "resultsDir/run_<id>/subsampleResult_0"
     return dir / ("subsampleResult_" + std::to_string(index));
 }
 
-// Creates the directory.
+// Buffer of at least bytes, aligned for O_DIRECT
+_SubsampleResultIO::_AlignedBuffer _SubsampleResultIO::_allocateAligned(size_t bytes)
+{
+    // aligned_alloc requires a size that is a multiple of the alignment
+    void *data = std::aligned_alloc(DIRECT_IO_ALIGNMENT, alignUp(std::max<size_t>(bytes, 1)));
+    if (!data)
+        throw std::bad_alloc();
+    return _AlignedBuffer(static_cast<char *>(data), std::free);
+}
+
+// Open a result file of the compressed layout, with O_DIRECT if enabled
+int _SubsampleResultIO::_openResultFile(const std::filesystem::path &filePath, int flags, bool &direct)
+{
+    direct = _directIO.load(std::memory_order_relaxed);
+    if (direct)
+    {
+        int fd = ::open(filePath.c_str(), flags | O_DIRECT, 0644);
+        if (fd >= 0 || errno != EINVAL)
+            return fd;
+        // The file system does not support O_DIRECT (e.g., tmpfs before Linux 6.6), use buffered I/O from now on
+        if (_directIO.exchange(false))
+            VOTE_ENSEMBLE_LOG(LogLevel::Warning, "_SubsampleResultIO: O_DIRECT is not supported for "
+                                                     << filePath.parent_path().string() << ", using buffered I/O");
+        direct = false;
+    }
+    return ::open(filePath.c_str(), flags, 0644);
+}
+
+// Write a new result file without leaving the written pages in the page cache
+void _SubsampleResultIO::_writeResultFile(const std::filesystem::path &filePath, char *data, size_t size)
+{
+    bool direct = false;
+    int fd = _openResultFile(filePath, O_WRONLY | O_CREAT | O_TRUNC, direct);
+    if (fd < 0)
+        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to open file for writing: " +
+                                 filePath.string() + ": " + std::strerror(errno));
+
+    bool ok;
+    if (direct)
+    {
+        // O_DIRECT transfers whole aligned blocks, so the padding is written (zeroed) and cut off afterwards
+        size_t paddedSize = alignUp(size);
+        std::memset(data + size, 0, paddedSize - size);
+        ok = writeAll(fd, data, paddedSize) && ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+    }
+    else
+    {
+        /**
+         * DONTNEED starts the writeback of the dirty pages and drops those already written, so results do not
+         * accumulate in the page cache. Pages still under writeback stay until reclaimed or the file is deleted.
+         */
+        ok = writeAll(fd, data, size);
+        if (ok)
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    int error = errno;
+    if (::close(fd) != 0 && ok)
+        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to close file after writing: " +
+                                 filePath.string() + ": " + std::strerror(errno));
+    if (!ok)
+        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to write compressed data to file: " +
+                                 filePath.string() + ": " + std::strerror(error));
+}
+
+// Read a whole result file into an aligned buffer
+_SubsampleResultIO::_AlignedBuffer _SubsampleResultIO::_readResultFile(const std::filesystem::path &filePath, size_t &size)
+{
+    bool direct = false;
+    int fd = _openResultFile(filePath, O_RDONLY, direct);
+    if (fd < 0)
+        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Failed to open file for reading: " +
+                                 filePath.string() + ": " + std::strerror(errno));
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Failed to stat file: " + filePath.string() +
+                                 ": " + std::strerror(error));
+    }
+    size = static_cast<size_t>(status.st_size);
+
+    // With O_DIRECT, the read covers whole blocks and stops short at the end of the file
+    _AlignedBuffer data = _allocateAligned(size);
+    ssize_t got = readAll(fd, data.get(), direct ? alignUp(size) : size);
+    int error = errno;
+    ::close(fd);
+    if (got < 0 || static_cast<size_t>(got) < size)
+        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Failed to read compressed data from file: " +
+                                 filePath.string() + (got < 0 ? std::string(": ") + std::strerror(error) : std::string()));
+    return data;
+}
+
+// Atomically create a new uniquely named subdirectory of rootDir
+std::filesystem::path _SubsampleResultIO::_createUniqueRunDir(const std::filesystem::path &rootDir)
+{
+    /**
+     * The name mixes a random device, the time, the thread id and a process-wide counter.
+     * Uniqueness does not rely on the name alone: create_directory is a single mkdir, which fails
+     * if the directory already exists, so a collision with another process is detected and retried.
+     */
+    static std::atomic<unsigned long long> counter{0};
+    std::random_device rd;
+    std::seed_seq seq{rd(), rd(),
+                      static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count()),
+                      static_cast<unsigned int>(std::hash<std::thread::id>{}(std::this_thread::get_id())),
+                      static_cast<unsigned int>(counter.fetch_add(1))};
+    std::mt19937_64 rng(seq);
+
+    const int maxAttempts = 100;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt)
+    {
+        std::ostringstream name;
+        name << "run_" << std::hex << rng();
+        std::filesystem::path runDir = rootDir / name.str();
+
+        std::error_code ec;
+        if (std::filesystem::create_directory(runDir, ec))
+            return runDir; // Created by us, so nobody else is using it
+        if (ec)
+            throw std::runtime_error("_SubsampleResultIO::_createUniqueRunDir: Error when creating directory: " +
+                                     runDir.string() + ": " + ec.message());
+        // Otherwise the directory already exists, try another name
+    }
+    throw std::runtime_error("_SubsampleResultIO::_createUniqueRunDir: Failed to create a unique directory in: " +
+                             rootDir.string());
+}
+
+// Creates the storage root (if needed) and the namespace directory of this object.
 void _SubsampleResultIO::_prepareSubsampleResultDir()
 {
-    if (_resultDir)
+    if (_resultDir && !_runDir)
     {
         try
         {
-            if (!std::filesystem::exists(*_resultDir))
-            {
-                // Note: *_resultDir dereferences the optional, giving a path
-                std::filesystem::create_directories(*_resultDir);
-            }
+            /**
+             * Note: *_resultDir dereferences the optional, giving a path
+             * The root may be created concurrently by other runs, so an existing directory is not an error.
+             */
+            std::error_code ec;
+            std::filesystem::create_directories(*_resultDir, ec);
+            if (!std::filesystem::is_directory(*_resultDir))
+                throw std::runtime_error(ec ? ec.message() : "path exists and is not a directory");
+
+            _runDir = _createUniqueRunDir(*_resultDir);
         }
         catch (const std::filesystem::filesystem_error &e)
         {
@@ -72,12 +308,166 @@ void _SubsampleResultIO::_prepareSubsampleResultDir()
     }
 }
 
+// Remove the namespace directory with its content when this object is destroyed
+void _SubsampleResultIO::_setRemoveRunDirOnDestruction(bool remove)
+{
+    _removeRunDir = remove;
+}
+
+// Helper functions of the fixed-stride layout
+bool _SubsampleResultIO::_isFixedStride() const
+{
+    return _layout != StorageLayout::Compressed;
+}
+
+size_t _SubsampleResultIO::_slotBytes() const
+{
+    return sizeof(std::uint64_t) + static_cast<size_t>(_resultSize) * sizeof(double);
+}
+
+// FNV-1a over the raw bytes of the result and the slot index. The result is never 0, which marks an empty slot.
+std::uint64_t _SubsampleResultIO::_slotChecksum(const double *data, Eigen::Index size, int index)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const unsigned char *bytes, size_t numBytes)
+    {
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(reinterpret_cast<const unsigned char *>(&index), sizeof(index));
+    mix(reinterpret_cast<const unsigned char *>(data), static_cast<size_t>(size) * sizeof(double));
+    return hash == 0 ? 1 : hash;
+}
+
+// Create the file and the mapping (or grow them), must be called with _mappingMutex held
+void _SubsampleResultIO::_mapSlotsLocked(int numSlots, Eigen::Index resultSize)
+{
+    if (!_runDir)
+        throw std::runtime_error("_SubsampleResultIO::_mapSlots: Result directory is not prepared.");
+    std::filesystem::path filePath = *_runDir / FIXED_STRIDE_FILE_NAME;
+
+    if (_fd < 0)
+    {
+        _fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (_fd < 0)
+            throw std::runtime_error("_SubsampleResultIO::_mapSlots: Failed to open file: " + filePath.string() +
+                                     ": " + std::strerror(errno));
+    }
+    if (_mapping)
+        _unmapSlots();
+
+    _resultSize = resultSize;
+    _numSlots = numSlots;
+    _mappingBytes = static_cast<size_t>(numSlots) * _slotBytes();
+
+    // ftruncate zero-fills the new part of the file, so new slots start empty
+    if (::ftruncate(_fd, static_cast<off_t>(_mappingBytes)) != 0)
+        throw std::runtime_error("_SubsampleResultIO::_mapSlots: Failed to resize file: " + filePath.string() +
+                                 ": " + std::strerror(errno));
+    void *mapping = ::mmap(nullptr, _mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("_SubsampleResultIO::_mapSlots: Failed to map file: " + filePath.string() +
+                                 ": " + std::strerror(errno));
+    _mapping = static_cast<char *>(mapping);
+    // Slots are accessed by index, so readahead around a slot only fills the page cache (a hint, errors are ignored)
+    ::madvise(_mapping, _mappingBytes, MADV_RANDOM);
+}
+
+void _SubsampleResultIO::_unmapSlots()
+{
+    if (_mapping)
+    {
+        ::munmap(_mapping, _mappingBytes);
+        _mapping = nullptr;
+        _mappingBytes = 0;
+    }
+}
+
+// Pointer to the header of slot index, checks the index and that the slot was written
+const char *_SubsampleResultIO::_readableSlot(int index)
+{
+    if (!_mapping || index < 0 || index >= _numSlots)
+        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: No result stored for index: " +
+                                 std::to_string(index));
+
+    const char *slot = _mapping + static_cast<size_t>(index) * _slotBytes();
+    std::uint64_t header;
+    std::memcpy(&header, slot, sizeof(header));
+    if (header == 0)
+        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: No result stored for index: " +
+                                 std::to_string(index));
+    if (_layout == StorageLayout::FixedStrideChecked)
+    {
+        const double *data = reinterpret_cast<const double *>(slot + sizeof(std::uint64_t));
+        if (header != _slotChecksum(data, _resultSize, index))
+            throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Checksum mismatch for index: " +
+                                     std::to_string(index));
+    }
+    return slot;
+}
+
+// Copy the result into its slot of the mapped file
+void _SubsampleResultIO::_dumpFixedStride(const Result &learningResult, int index)
+{
+    char *mapping = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mappingMutex);
+        if (index < 0 || index >= _numSlots)
+            throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Index " + std::to_string(index) +
+                                     " is out of the prepared slots, call _prepareSlots first.");
+        if (!_mapping)
+            _mapSlotsLocked(_numSlots, learningResult.size()); // The first result determines the slot size
+        else if (learningResult.size() != _resultSize)
+            throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: The fixed-stride layout requires results of "
+                                     "equal length. Expected " + std::to_string(_resultSize) + ", got " +
+                                     std::to_string(learningResult.size()) + ". Use StorageLayout::Compressed instead.");
+        mapping = _mapping;
+    }
+
+    // Write the data first and the header last, so a nonzero header marks a complete slot
+    char *slot = mapping + static_cast<size_t>(index) * _slotBytes();
+    std::uint64_t header = _layout == StorageLayout::FixedStrideChecked
+                               ? _slotChecksum(learningResult.data(), _resultSize, index)
+                               : 1;
+    if (_resultSize > 0)
+        std::memcpy(slot + sizeof(std::uint64_t), learningResult.data(), static_cast<size_t>(_resultSize) * sizeof(double));
+    std::memcpy(slot, &header, sizeof(header));
+    _LibraryMetrics::get().storageWrittenBytes.add(_slotBytes());
+}
+
+// Announce that results with indices in [0, numSlots) will be dumped
+void _SubsampleResultIO::_prepareSlots(int numSlots)
+{
+    if (!_resultDir || !_isFixedStride())
+        return;
+    std::lock_guard<std::mutex> lock(_mappingMutex);
+    if (numSlots <= _numSlots)
+        return; // Never shrink, slots of kept results stay readable
+    if (_mapping)
+        _mapSlotsLocked(numSlots, _resultSize);
+    else
+        _numSlots = numSlots; // The file is created by the first dump
+}
+
 // Save the learning result to a file.
 void _SubsampleResultIO::_dumpSubsampleResult(const Result &learningResult, int index)
 {
+    if (_isFixedStride())
+    {
+        _dumpFixedStride(learningResult, index);
+        return;
+    }
+
     if (!_resultDir)
         throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: External storage is not enabled.");
-    std::filesystem::path resultPath = _subsampleResultPath(*_resultDir, index);
+    if (!_runDir)
+        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Result directory is not prepared.");
+    std::filesystem::path resultPath = _subsampleResultPath(*_runDir, index);
+    std::filesystem::path tempPath = resultPath;
+    tempPath += ".tmp";
 
     // 1. Serialize Result to in-memory buffer using BaseLearner's method
     std::stringstream memoryStream(std::ios::in | std::ios::out | std::ios::binary);
@@ -92,64 +482,74 @@ void _SubsampleResultIO::_dumpSubsampleResult(const Result &learningResult, int
     }
     std::string serializedData = memoryStream.str(); // Get data as string/byte sequence
 
-    // 2. Compress the serialized data using ZSTD (same as in the python version)
+    // 2. Compress the serialized data using ZSTD (same as in the python version), into a buffer suitable for O_DIRECT
     size_t cBufferSize = ZSTD_compressBound(serializedData.size());
-    std::vector<char> compressedData(cBufferSize);
+    _AlignedBuffer compressedData = _allocateAligned(cBufferSize);
 
     // Compress the data and return the size
-    size_t const cSize = ZSTD_compress(compressedData.data(), cBufferSize,
+    size_t const cSize = ZSTD_compress(compressedData.get(), cBufferSize,
                                        serializedData.data(), serializedData.size(), 1);
 
     if (ZSTD_isError(cSize))
         throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: ZSTD compression error for index " +
                                  std::to_string(index) + ": " + ZSTD_getErrorName(cSize));
 
-    // 3. Write the compressed data to the file
-    std::ofstream outFile(resultPath, std::ios::binary | std::ios::trunc); // binary mode, clear existing content if any
-    if (!outFile)
-        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to open file for writing: " + resultPath.string());
+    // 3. Write the compressed data to a temporary file (clear existing content if any)
+    _writeResultFile(tempPath, compressedData.get(), cSize);
+    _LibraryMetrics::get().storageWrittenBytes.add(cSize);
 
-    outFile.write(compressedData.data(), cSize);
-    if (!outFile)
+    // 4. Rename to the final name, so that a result file is either absent or complete
+    std::error_code ec;
+    std::filesystem::rename(tempPath, resultPath, ec);
+    if (ec)
     {
-        // Attempt close before throwing
-        outFile.close();
-        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to write compressed data to file: " + resultPath.string());
+        std::filesystem::remove(tempPath, ec);
+        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to rename file: " + tempPath.string() +
+                                 " to " + resultPath.string());
     }
+}
 
-    outFile.close(); // Close the file
-    if (!outFile)
-        throw std::runtime_error("_SubsampleResultIO::_dumpSubsampleResult: Failed to close file after writing: " + resultPath.string());
+// Load the learning result into buffer, reusing its allocation when possible.
+void _SubsampleResultIO::_loadSubsampleResult(int index, Result &buffer)
+{
+    if (!_isFixedStride())
+    {
+        buffer = _loadSubsampleResult(index);
+        return;
+    }
+
+    // The mapping is not modified while results are read, so no lock is needed here
+    const char *slot = _readableSlot(index);
+    buffer.resize(_resultSize); // No-op if the size already matches
+    if (_resultSize > 0)
+        std::memcpy(buffer.data(), slot + sizeof(std::uint64_t), static_cast<size_t>(_resultSize) * sizeof(double));
+    _LibraryMetrics::get().storageReadBytes.add(sizeof(std::uint64_t) + static_cast<size_t>(_resultSize) * sizeof(double));
 }
 
 // Load the learning result from a file (a single solution).
 Result _SubsampleResultIO::_loadSubsampleResult(int index)
 {
-    if (!_resultDir)
+    if (_isFixedStride())
+    {
+        Result learningResult;
+        _loadSubsampleResult(index, learningResult);
+        return learningResult;
+    }
+
+    if (!_resultDir || !_runDir)
         throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: External storage is not enabled.");
-    std::filesystem::path resultPath = _subsampleResultPath(*_resultDir, index);
+    std::filesystem::path resultPath = _subsampleResultPath(*_runDir, index);
 
     if (!std::filesystem::exists(resultPath))
         throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: File not found for loading result: " + resultPath.string());
 
     // 1. Read the compressed data from the file
-    std::ifstream inFile(resultPath, std::ios::binary | std::ios::ate); // binary mode, seek to end
-    if (!inFile)
-        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Failed to open file for reading: " + resultPath.string());
-    std::streamsize compressedSize = inFile.tellg(); // Get the size of the file
-    inFile.seekg(0, std::ios::beg);                  // Seek back to the beginning
-
-    std::vector<char> compressedData(compressedSize);
-    if (!inFile.read(compressedData.data(), compressedSize))
-    {
-        inFile.close();
-        throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: Failed to read compressed data from file: " +
-                                 resultPath.string());
-    }
-    inFile.close(); // Close the file
+    size_t compressedSize = 0;
+    _AlignedBuffer compressedData = _readResultFile(resultPath, compressedSize);
+    _LibraryMetrics::get().storageReadBytes.add(static_cast<std::uint64_t>(compressedSize));
 
     // 2. Decompress the data using ZSTD
-    unsigned long long const bufferSize = ZSTD_getFrameContentSize(compressedData.data(), compressedSize);
+    unsigned long long const bufferSize = ZSTD_getFrameContentSize(compressedData.get(), compressedSize);
     if (bufferSize == ZSTD_CONTENTSIZE_ERROR)
         throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: File is not a valid ZSTD compressed file: " +
                                  resultPath.string());
@@ -159,7 +559,7 @@ Result _SubsampleResultIO::_loadSubsampleResult(int index)
 
     std::vector<char> decompressedData(bufferSize);
     size_t const decompressedSize = ZSTD_decompress(decompressedData.data(), bufferSize,
-                                                    compressedData.data(), compressedSize);
+                                                    compressedData.get(), compressedSize);
 
     if (ZSTD_isError(decompressedSize))
         throw std::runtime_error("_SubsampleResultIO::_loadSubsampleResult: ZSTD decompression error for index: " +
@@ -189,11 +589,22 @@ Result _SubsampleResultIO::_loadSubsampleResult(int index)
 // Delete the learning result files for the given indices.
 void _SubsampleResultIO::_deleteSubsampleResult(const std::vector<int> &indexList)
 {
-    if (!_resultDir)
+    if (!_resultDir || !_runDir)
         return; // No need to delete if external storage is not enabled
+    if (_isFixedStride())
+    {
+        // Mark the slots as empty, the file itself is removed by the destructor once all slots are empty
+        std::lock_guard<std::mutex> lock(_mappingMutex);
+        for (int index : indexList)
+        {
+            if (_mapping && index >= 0 && index < _numSlots)
+                std::memset(_mapping + static_cast<size_t>(index) * _slotBytes(), 0, sizeof(std::uint64_t));
+        }
+        return;
+    }
     for (int index : indexList)
     {
-        std::filesystem::path resultPath = _subsampleResultPath(*_resultDir, index);
+        std::filesystem::path resultPath = _subsampleResultPath(*_runDir, index);
         try
         {
             if (std::filesystem::exists(resultPath))
@@ -203,13 +614,13 @@ void _SubsampleResultIO::_deleteSubsampleResult(const std::vector<int> &indexLis
         }
         catch (const std::filesystem::filesystem_error &e)
         {
-            std::cerr << "_SubsampleResultIO::_deleteSubsampleResult: Filesystem error when deleting file: "
-                      << resultPath.string() << ": " << e.what() << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Error, "_SubsampleResultIO::_deleteSubsampleResult: Filesystem error when deleting file: "
+                                                   << resultPath.string() << ": " << e.what());
         }
         catch (const std::exception &e)
         {
-            std::cerr << "_SubsampleResultIO::_deleteSubsampleResult: Error when deleting file: "
-                      << resultPath.string() << ": " << e.what() << std::endl;
+            VOTE_ENSEMBLE_LOG(LogLevel::Error, "_SubsampleResultIO::_deleteSubsampleResult: Error when deleting file: "
+                                                   << resultPath.string() << ": " << e.what());
         }
     }
 }
@@ -221,8 +632,20 @@ bool _SubsampleResultIO::isExternalStorateEnabled() const
     return _resultDir.has_value();
 }
 
-// Get the result directory path.
+// Get the result directory path (the storage root).
 const std::optional<std::filesystem::path> &_SubsampleResultIO::getResultDir() const
 {
     return _resultDir;
+}
+
+// Get the namespace directory where the results of this object are stored.
+const std::optional<std::filesystem::path> &_SubsampleResultIO::getRunDir() const
+{
+    return _runDir;
+}
+
+// Get the layout of the results in external storage.
+StorageLayout _SubsampleResultIO::getLayout() const
+{
+    return _layout;
 }
\ No newline at end of file
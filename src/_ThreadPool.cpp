@@ -0,0 +1,48 @@
+#include "_ThreadPool.hpp"
+
+#include <algorithm> // For std::max
+
+// Constructor
+_ThreadPool::_ThreadPool(int numWorkers)
+{
+    numWorkers = std::max(1, numWorkers);
+    _workers.reserve(numWorkers);
+    for (int i = 0; i < numWorkers; ++i)
+        _workers.emplace_back(&_ThreadPool::_workerLoop, this);
+}
+
+// Destructor
+_ThreadPool::~_ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+    for (std::thread &worker : _workers)
+        worker.join();
+}
+
+int _ThreadPool::numWorkers() const
+{
+    return static_cast<int>(_workers.size());
+}
+
+// Loop of each worker
+void _ThreadPool::_workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]()
+                            { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty())
+                return; // Stopping and nothing left to run
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task(); // packaged_task stores exceptions in the future, so none escape
+    }
+}
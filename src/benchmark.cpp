@@ -0,0 +1,245 @@
+#include "types.hpp"
+#include "MoVE.hpp"
+#include "ROVE.hpp"
+#include "SyntheticLearner.hpp"
+#include "ThreadConfig.hpp"
+#include "ToolUtils.hpp"
+
+#include <string>
+#include <vector>
+#include <iostream>  // For std::cout, std::cerr
+#include <iomanip>   // For std::setw
+#include <optional>  // For std::optional
+#include <chrono>    // For timing
+#include <stdexcept> // For std::exception
+#include <algorithm> // For std::sort
+#include <limits>    // For std::numeric_limits
+#include <memory>    // For std::unique_ptr
+#include <functional> // For std::function
+
+/**
+ * Benchmarks of the infrastructure (scheduling, storage and voting), driven by SyntheticLearner.
+ * Each benchmark prints one line per configuration with the wall time of a full run (synthetic),
+ * or with percentiles of the wall time of repeated runs (latency).
+ */
+
+// Time a callable in seconds
+template <typename Func>
+static double timeSeconds(Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * Run MoVE and ROVE under each load shape (constant, log-normal and straggler learning costs)
+ * and each storage mode (in memory, compressed files, fixed-stride file), and in memory with a learn deadline.
+ */
+void runSyntheticBenchmark()
+{
+    const size_t n = 20000;
+    const int p = 8;
+    const unsigned int dataSeed = 888;
+    const unsigned int algoSeed = 999;
+    const std::string storageDir = "./bench_storage";
+
+    Sample sample = generateSyntheticData(n, p, dataSeed);
+    std::cout << "Synthetic benchmark (N=" << n << ", P=" << p << ", " << autoThreadConfig().toString() << ")" << std::endl;
+
+    struct LoadShape
+    {
+        std::string name;
+        CostModel learnCost;
+    };
+    std::vector<LoadShape> loadShapes = {
+        {"constant", {CostDistribution::Constant, 200.0}},
+        {"lognormal", {CostDistribution::LogNormal, 200.0, 1.0}},
+        {"stragglers", {CostDistribution::Stragglers, 200.0, 1.0, 0.01, 100.0}},
+    };
+    std::vector<std::optional<StorageLayout>> layouts = {std::nullopt, StorageLayout::Compressed, StorageLayout::FixedStride};
+
+    std::cout << std::left << std::setw(12) << "load" << std::setw(22) << "storage"
+              << std::setw(8) << "method" << "seconds" << std::endl;
+    for (const LoadShape &shape : loadShapes)
+    {
+        SyntheticLearnerConfig config;
+        config.learnCost = shape.learnCost;
+        config.objectiveCostPerRow = {CostDistribution::Constant, 0.05};
+        config.resultSize = 16;
+        config.duplicateRate = 0.7;
+        config.numDuplicateCandidates = 8;
+        config.enableDeduplication = true;
+        config.serializedBytes = 4096;
+        config.seed = algoSeed;
+        SyntheticLearner learner(config);
+
+        for (const auto &layout : layouts)
+        {
+            std::optional<std::string> dir = layout ? std::optional<std::string>(storageDir) : std::nullopt;
+            StorageLayout storageLayout = layout.value_or(StorageLayout::Compressed);
+
+            double moveSeconds = timeSeconds([&]()
+                                             {
+                MoVE move(&learner, AUTO_NUM_THREADS, {algoSeed}, dir, true, storageLayout);
+                move.run(sample, 200); });
+            std::cout << std::setw(12) << shape.name << std::setw(22) << layoutName(layout)
+                      << std::setw(8) << "MoVE" << moveSeconds << std::endl;
+
+            double roveSeconds = timeSeconds([&]()
+                                             {
+                ROVE rove(&learner, false, AUTO_NUM_THREADS, AUTO_NUM_THREADS, {algoSeed}, dir, true, storageLayout);
+                rove.run(sample, 50, 200); });
+            std::cout << std::setw(12) << shape.name << std::setw(22) << layoutName(layout)
+                      << std::setw(8) << "ROVE" << roveSeconds << std::endl;
+        }
+
+        // In memory, with learning abandoned and replaced at 10 times the median cost (see setLearnDeadline)
+        std::chrono::microseconds deadline(static_cast<long long>(10 * shape.learnCost.medianMicros));
+        unsigned long long moveReplaced = 0, roveReplaced = 0;
+        double moveSeconds = timeSeconds([&]()
+                                         {
+            MoVE move(&learner, AUTO_NUM_THREADS, {algoSeed});
+            move.setLearnDeadline(deadline);
+            move.run(sample, 200);
+            moveReplaced = move.numReplacedSubsamples(); });
+        std::cout << std::setw(12) << shape.name << std::setw(22) << "memory+deadline"
+                  << std::setw(8) << "MoVE" << moveSeconds << " (" << moveReplaced << " replaced)" << std::endl;
+
+        double roveSeconds = timeSeconds([&]()
+                                         {
+            ROVE rove(&learner, false, AUTO_NUM_THREADS, AUTO_NUM_THREADS, {algoSeed});
+            rove.setLearnDeadline(deadline);
+            rove.run(sample, 50, 200);
+            roveReplaced = rove.numReplacedSubsamples(); });
+        std::cout << std::setw(12) << shape.name << std::setw(22) << "memory+deadline"
+                  << std::setw(8) << "ROVE" << roveSeconds << " (" << roveReplaced << " replaced)" << std::endl;
+    }
+}
+
+/**
+ * Measure the latency of single MoVE and ROVE runs on small problems, where the fixed overhead of threads
+ * and storage setup dominates. The learner costs nothing beyond gathering the subsamples and computing the
+ * objective, so the times are those of the infrastructure. Each configuration reuses one object for all
+ * repetitions, as a service answering many small requests would.
+ * Modes: "parallel" forces worker threads with in-memory results, "storage" also uses a storage directory,
+ * and "inline" forces the small problem path. The work (see _BaseVE::setSmallProblemThreshold) is printed
+ * to compare with the default threshold.
+ */
+void runLatencyBenchmark()
+{
+    const int p = 8;
+    const unsigned int dataSeed = 888;
+    const unsigned int algoSeed = 999;
+    const int numWarmup = 3;
+    const int numRepetitions = 50;
+    const std::string storageDir = "./bench_storage";
+
+    SyntheticLearnerConfig config;
+    config.resultSize = 8;
+    config.duplicateRate = 0.9;
+    config.numDuplicateCandidates = 4;
+    config.enableDeduplication = true;
+    config.seed = algoSeed;
+    SyntheticLearner learner(config);
+
+    std::cout << "Latency benchmark (P=" << p << ", " << autoThreadConfig().toString()
+              << ", default small problem threshold " << _BaseVE::DEFAULT_SMALL_PROBLEM_THRESHOLD << ")" << std::endl;
+    std::cout << std::left << std::setw(8) << "n" << std::setw(8) << "method" << std::setw(10) << "mode"
+              << std::setw(12) << "work" << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)"
+              << std::setw(12) << "min (us)" << std::endl;
+
+    struct Mode
+    {
+        std::string name;
+        double threshold;
+        bool storage;
+    };
+    std::vector<Mode> modes = {
+        {"parallel", 0.0, false},
+        {"storage", 0.0, true},
+        {"inline", std::numeric_limits<double>::infinity(), false},
+    };
+
+    for (size_t n : {1000, 3000, 10000, 30000})
+    {
+        Sample sample = generateSyntheticData(n, p, dataSeed);
+        for (const std::string method : {"MoVE", "ROVE"})
+        {
+            for (const Mode &mode : modes)
+            {
+                std::optional<std::string> dir = mode.storage ? std::optional<std::string>(storageDir) : std::nullopt;
+                std::unique_ptr<_BaseVE> ensemble;
+                std::function<void()> runOnce;
+                double work;
+                int k = std::max(30, static_cast<int>(n / 200));
+                if (method == "MoVE")
+                {
+                    auto move = std::make_unique<MoVE>(&learner, AUTO_NUM_THREADS, algoSeed, dir);
+                    runOnce = [&sample, ensemble = move.get()]()
+                    { ensemble->run(sample, 200); };
+                    work = static_cast<double>(n) * 200 * k;
+                    ensemble = std::move(move);
+                }
+                else
+                {
+                    auto rove = std::make_unique<ROVE>(&learner, false, AUTO_NUM_THREADS, AUTO_NUM_THREADS, algoSeed, dir);
+                    runOnce = [&sample, ensemble = rove.get()]()
+                    { ensemble->run(sample, 50, 200); };
+                    work = static_cast<double>(n) * (50 + 200) * k;
+                    ensemble = std::move(rove);
+                }
+                ensemble->setSmallProblemThreshold(mode.threshold);
+
+                for (int r = 0; r < numWarmup; ++r)
+                    runOnce();
+                std::vector<double> micros;
+                micros.reserve(numRepetitions);
+                for (int r = 0; r < numRepetitions; ++r)
+                    micros.push_back(1e6 * timeSeconds(runOnce));
+                std::sort(micros.begin(), micros.end());
+
+                std::cout << std::setw(8) << n << std::setw(8) << method << std::setw(10) << mode.name
+                          << std::setw(12) << work << std::setw(12) << percentile(micros, 0.5)
+                          << std::setw(12) << percentile(micros, 0.99)
+                          << std::setw(12) << micros.front() << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <BenchmarkName>" << std::endl;
+        std::cerr << "Available BenchmarkName: synthetic, latency" << std::endl;
+        return 1;
+    }
+
+    std::string benchmarkName = argv[1];
+    try
+    {
+        if (benchmarkName == "synthetic")
+        {
+            runSyntheticBenchmark();
+        }
+        else if (benchmarkName == "latency")
+        {
+            runLatencyBenchmark();
+        }
+        else
+        {
+            std::cerr << "Unknown BenchmarkName: " << benchmarkName << std::endl;
+            std::cerr << "Available BenchmarkName: synthetic, latency" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "\n!!! An exception occurred during execution: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,14 +3,13 @@
 #include "LinearProgramLearner.hpp"
 #include "ROVE.hpp"
 #include "VoteEnsembleRunner.hpp"
+#include "ThreadConfig.hpp"
 
 #include <string>
 #include <vector>
 #include <iostream>    // For input/output (std::cout, std::cerr)
 #include <stdexcept>   // For std::exception
 #include <Eigen/Dense> // For Eigen operations during data generation
-#include <algorithm>   // For std::min
-#include <thread>      // For std::thread::hardware_concurrency (optional)
 #include <chrono>      // For timing.
 
 void runLRExample()
@@ -23,7 +22,7 @@ void runLRExample()
     const double noiseStDev = 5.0;
     const unsigned int dataSeed = 888;
     const unsigned int algSeed = 999;
-    const int numThreads = std::min(1u, std::thread::hardware_concurrency() / 2); // add u after 4 to match the type of hardware_concurrency
+    const int numThreads = AUTO_NUM_THREADS; // Chosen per phase from the CPUs available to the process
     const std::string subsampleResultsDir = "./LR_storage_test";
 
     // Generate data and print true result
@@ -54,7 +53,7 @@ void runLPExample()
     const double noiseStDev = 2.0;
     const unsigned int dataSeed = 888;
     const unsigned int algoSeed = 999;
-    const int numThreads = std::min(1u, std::thread::hardware_concurrency() / 2); // add u after 4 to match the type of hardware_concurrency
+    const int numThreads = AUTO_NUM_THREADS; // Chosen per phase from the CPUs available to the process
     const std::string subsampleResultsDir = "./LP_storage_test";
 
     // Generate data and print true result
@@ -72,6 +71,9 @@ void runLPExample()
     runROVE("ROVE", baseLearnerPtr, sample, false, numThreads, algoSeed);
     runROVE("ROVEs", baseLearnerPtr, sample, true, numThreads, algoSeed);
 
+    // Run MoVE and ROVE with shared Phase I learning (MoVE uses B = B1)
+    runMoVEAndROVE("MoVE+ROVE", baseLearnerPtr, sample, numThreads, algoSeed);
+
     // Run MoVE, ROVE, and ROVEs (default parameters with external storage enabled)
     // runMoVE("MoVE", baseLearnerPtr, sample, numThreads, algoSeed, subsampleResultsDir + "/MoVE", true);
     // runROVE("ROVE", baseLearnerPtr, sample, false, numThreads, algoSeed, subsampleResultsDir + "/ROVE", true);
@@ -91,6 +93,7 @@ int main(int argc, char *argv[])
     }
 
     std::string exampleName = argv[1];
+    std::cout << "Thread configuration: " << autoThreadConfig().toString() << std::endl;
 
     try
     {
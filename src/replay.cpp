@@ -0,0 +1,412 @@
+#include "types.hpp"
+#include "MoVE.hpp"
+#include "ROVE.hpp"
+#include "LinearRegressionLearner.hpp"
+#include "LinearProgramLearner.hpp"
+#include "SyntheticLearner.hpp"
+#include "ThreadConfig.hpp"
+#include "ToolUtils.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <iostream>  // For std::cout, std::cerr
+#include <iomanip>   // For std::setw
+#include <fstream>   // For std::ifstream
+#include <sstream>   // For std::istringstream
+#include <optional>  // For std::optional
+#include <chrono>    // For arrival times and latencies
+#include <thread>    // For std::thread, std::this_thread::sleep_until
+#include <atomic>    // For std::atomic (next job)
+#include <stdexcept> // For std::exception, std::invalid_argument, std::runtime_error
+#include <algorithm> // For std::sort, std::stable_sort
+
+/**
+ * Replay of a job trace against the library, to measure the end-to-end behavior of a service that runs a mix
+ * of jobs (e.g., many small LP MoVE jobs interleaved with a few large LR ROVE jobs).
+ *
+ * The trace is a CSV file with a header line naming the columns, in any order:
+ *   arrival_ms  time of arrival of the job, in milliseconds from the start of the replay (required)
+ *   learner     LR, LP or Synthetic (required)
+ *   method      MoVE or ROVE (required)
+ *   n           number of rows of the dataset (required)
+ *   p           number of features (LR and Synthetic, LP is always 2)
+ *   B           number of subsamples of MoVE, or of Phase I of ROVE (required)
+ *   k           subsample size of MoVE, or of Phase I of ROVE (empty for the default)
+ *   B2          number of subsamples of Phase II of ROVE (default 200)
+ *   storage     memory, compressed, fixed-stride or fixed-stride-checked (default memory)
+ * Empty fields take the default, and lines starting with '#' are ignored.
+ *
+ * Jobs are released at their arrival time (scaled by --time-scale) into a queue served by --concurrency
+ * workers, in arrival order. The latency of a job runs from its scheduled arrival to its completion, so it
+ * includes the time spent waiting for a worker. Each job constructs its own MoVE or ROVE object; the
+ * datasets are generated before the replay starts, so that data generation is not measured.
+ */
+
+namespace
+{
+    struct TraceJob
+    {
+        int line = 0;
+        double arrivalMs = 0.0;
+        std::string learner;
+        std::string method;
+        long long n = 0;
+        int p = 0;
+        int B = 0;
+        std::optional<int> k;
+        int B2 = 200;
+        std::optional<StorageLayout> storage;
+    };
+
+    struct ReplayOptions
+    {
+        std::string tracePath;
+        int concurrency = 1;
+        int numThreads = AUTO_NUM_THREADS;
+        std::string storageDir = "./replay_storage";
+        double timeScale = 1.0;
+    };
+
+    // Outcome of a job, measured on the worker that ran it
+    struct JobOutcome
+    {
+        bool ok = false;
+        std::string error;
+        double serviceSeconds = 0.0;
+        std::chrono::steady_clock::time_point finish;
+    };
+
+    std::optional<StorageLayout> parseStorage(const std::string &name)
+    {
+        if (name.empty() || name == "memory")
+            return std::nullopt;
+        if (name == "compressed")
+            return StorageLayout::Compressed;
+        if (name == "fixed-stride")
+            return StorageLayout::FixedStride;
+        if (name == "fixed-stride-checked")
+            return StorageLayout::FixedStrideChecked;
+        throw std::invalid_argument("unknown storage mode: " + name);
+    }
+
+    int defaultNumFeatures(const std::string &learner)
+    {
+        return learner == "LR" ? 10 : (learner == "LP" ? 2 : 8);
+    }
+
+    // Split a CSV line on commas, trimming spaces around each field
+    std::vector<std::string> splitFields(const std::string &line)
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ','))
+        {
+            size_t begin = field.find_first_not_of(" \t\r");
+            size_t end = field.find_last_not_of(" \t\r");
+            fields.push_back(begin == std::string::npos ? std::string() : field.substr(begin, end - begin + 1));
+        }
+        if (!line.empty() && line.back() == ',')
+            fields.emplace_back();
+        return fields;
+    }
+
+    // Read the trace, sorted by arrival time (jobs arriving at the same time keep the order of the file)
+    std::vector<TraceJob> readTrace(const std::string &path)
+    {
+        std::ifstream inFile(path);
+        if (!inFile)
+            throw std::runtime_error("readTrace: Failed to open trace file: " + path);
+
+        std::vector<TraceJob> jobs;
+        std::map<std::string, size_t> columns;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(inFile, line))
+        {
+            ++lineNumber;
+            std::vector<std::string> fields = splitFields(line);
+            if (fields.empty() || (fields.size() == 1 && fields[0].empty()) || fields[0].rfind("#", 0) == 0)
+                continue;
+
+            if (columns.empty())
+            {
+                for (size_t i = 0; i < fields.size(); ++i)
+                    columns[fields[i]] = i;
+                for (const char *required : {"arrival_ms", "learner", "method", "n", "B"})
+                {
+                    if (!columns.count(required))
+                        throw std::runtime_error("readTrace: Missing column " + std::string(required) + " in " + path);
+                }
+                continue;
+            }
+
+            auto field = [&](const std::string &name) -> std::string
+            {
+                auto it = columns.find(name);
+                return it != columns.end() && it->second < fields.size() ? fields[it->second] : std::string();
+            };
+            try
+            {
+                TraceJob job;
+                job.line = lineNumber;
+                job.arrivalMs = std::stod(field("arrival_ms"));
+                job.learner = field("learner");
+                job.method = field("method");
+                job.n = std::stoll(field("n"));
+                job.p = field("p").empty() ? defaultNumFeatures(job.learner) : std::stoi(field("p"));
+                job.B = std::stoi(field("B"));
+                if (!field("k").empty())
+                    job.k = std::stoi(field("k"));
+                if (!field("B2").empty())
+                    job.B2 = std::stoi(field("B2"));
+                job.storage = parseStorage(field("storage"));
+
+                if (job.learner != "LR" && job.learner != "LP" && job.learner != "Synthetic")
+                    throw std::invalid_argument("unknown learner: " + job.learner);
+                if (job.method != "MoVE" && job.method != "ROVE")
+                    throw std::invalid_argument("unknown method: " + job.method);
+                if (job.learner == "LP" && job.p != 2)
+                    throw std::invalid_argument("LP jobs have p = 2");
+                if (job.arrivalMs < 0 || job.n <= 0 || job.p <= 0)
+                    throw std::invalid_argument("arrival_ms must be non-negative, n and p positive");
+                jobs.push_back(job);
+            }
+            catch (const std::exception &e)
+            {
+                throw std::runtime_error("readTrace: Invalid job at " + path + ":" + std::to_string(lineNumber) +
+                                         ": " + e.what());
+            }
+        }
+        if (jobs.empty())
+            throw std::runtime_error("readTrace: No jobs in trace file: " + path);
+
+        std::stable_sort(jobs.begin(), jobs.end(), [](const TraceJob &a, const TraceJob &b)
+                         { return a.arrivalMs < b.arrivalMs; });
+        return jobs;
+    }
+
+    // Run a job on the calling thread, with its own MoVE or ROVE object
+    JobOutcome runJob(const TraceJob &job, const ReplayOptions &options, const Sample &sample, BaseLearner *learner,
+                      unsigned int seed)
+    {
+        JobOutcome outcome;
+        std::optional<std::string> dir = job.storage ? std::optional<std::string>(options.storageDir) : std::nullopt;
+        StorageLayout storageLayout = job.storage.value_or(StorageLayout::Compressed);
+        auto jobStart = std::chrono::steady_clock::now();
+        try
+        {
+            if (job.method == "MoVE")
+            {
+                MoVE move(learner, options.numThreads, seed, dir, true, storageLayout);
+                move.run(sample, job.B, job.k);
+            }
+            else
+            {
+                ROVE rove(learner, false, options.numThreads, options.numThreads, seed, dir, true, storageLayout);
+                rove.run(sample, job.B, job.B2, job.k);
+            }
+            outcome.ok = true;
+        }
+        catch (const std::exception &e)
+        {
+            outcome.error = e.what();
+        }
+        outcome.finish = std::chrono::steady_clock::now();
+        outcome.serviceSeconds = std::chrono::duration<double>(outcome.finish - jobStart).count();
+        return outcome;
+    }
+
+    // Print the latency percentiles (in milliseconds) of the jobs of a class
+    void printLatencies(const std::string &name, std::vector<double> latenciesMs, size_t numFailed)
+    {
+        std::cout << std::setw(18) << name << std::setw(8) << latenciesMs.size() << std::setw(8) << numFailed;
+        if (latenciesMs.empty())
+        {
+            std::cout << std::endl;
+            return;
+        }
+        std::sort(latenciesMs.begin(), latenciesMs.end());
+        std::cout << std::setw(12) << percentile(latenciesMs, 0.5) << std::setw(12) << percentile(latenciesMs, 0.95)
+                  << std::setw(12) << percentile(latenciesMs, 0.99)
+                  << std::setw(12) << latenciesMs.back() << std::endl;
+    }
+
+    void printUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " <trace.csv> [--concurrency N] [--threads N] [--storage-dir DIR]"
+                  << " [--time-scale X]" << std::endl;
+        std::cerr << "  --concurrency N    jobs running at once (default 1)" << std::endl;
+        std::cerr << "  --threads N        numParallelLearn/numParallelEval of each job (default: automatic)" << std::endl;
+        std::cerr << "  --storage-dir DIR  storage root of the jobs with external storage (default ./replay_storage)" << std::endl;
+        std::cerr << "  --time-scale X     multiply the arrival times by X (0 releases all jobs at once, default 1)" << std::endl;
+    }
+
+    ReplayOptions parseOptions(int argc, char *argv[])
+    {
+        ReplayOptions options;
+        options.tracePath = argv[1];
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string name = argv[i];
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value of option " + name);
+            std::string value = argv[++i];
+            if (name == "--concurrency")
+                options.concurrency = std::stoi(value);
+            else if (name == "--threads")
+                options.numThreads = std::stoi(value);
+            else if (name == "--storage-dir")
+                options.storageDir = value;
+            else if (name == "--time-scale")
+                options.timeScale = std::stod(value);
+            else
+                throw std::invalid_argument("Unknown option " + name);
+        }
+        if (options.concurrency <= 0)
+            throw std::invalid_argument("--concurrency must be positive");
+        if (options.timeScale < 0)
+            throw std::invalid_argument("--time-scale cannot be negative");
+        return options;
+    }
+}
+
+/**
+ * Run the jobs of the trace and print the throughput and the latency percentiles, in total and for each
+ * class of jobs (learner and method).
+ */
+void runReplay(const ReplayOptions &options)
+{
+    const unsigned int dataSeed = 888;
+    const unsigned int algoSeed = 999;
+    const double lrNoiseStDev = 5.0;
+    const std::vector<double> lpMeanVector = {0.0, 0.2};
+    const double lpNoiseStDev = 2.0;
+
+    std::vector<TraceJob> jobs = readTrace(options.tracePath);
+
+    // Datasets, one per (learner, n, p), generated before the replay
+    std::map<std::tuple<std::string, long long, int>, Sample> datasets;
+    for (const TraceJob &job : jobs)
+    {
+        auto key = std::make_tuple(job.learner, job.n, job.p);
+        if (datasets.count(key))
+            continue;
+        if (job.learner == "LR")
+            datasets[key] = generateLRData(job.n, job.p, lrNoiseStDev, dataSeed).first;
+        else if (job.learner == "LP")
+            datasets[key] = generateLPData(job.n, lpMeanVector, lpNoiseStDev, dataSeed);
+        else
+            datasets[key] = generateSyntheticData(job.n, job.p, dataSeed);
+    }
+
+    // One base learner per type, shared by the jobs (base learners allow concurrent calls)
+    LinearRegressionLearner lrLearner;
+    LinearProgramLearner lpLearner;
+    SyntheticLearnerConfig syntheticConfig;
+    syntheticConfig.enableDeduplication = true;
+    syntheticConfig.seed = algoSeed;
+    SyntheticLearner syntheticLearner(syntheticConfig);
+    auto learnerFor = [&](const std::string &name) -> BaseLearner *
+    {
+        if (name == "LR")
+            return &lrLearner;
+        if (name == "LP")
+            return &lpLearner;
+        return &syntheticLearner;
+    };
+
+    std::cout << "Replaying " << jobs.size() << " jobs from " << options.tracePath << " (concurrency "
+              << options.concurrency << ", time scale " << options.timeScale << ", "
+              << autoThreadConfig().toString() << ")" << std::endl;
+
+    std::vector<std::chrono::steady_clock::time_point> arrivals(jobs.size());
+    std::vector<JobOutcome> outcomes(jobs.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        arrivals[i] = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double, std::milli>(jobs[i].arrivalMs * options.timeScale));
+    }
+
+    /**
+     * Each worker takes the next job in arrival order and waits for its arrival, so the jobs that arrive while
+     * all workers are busy are queued in arrival order, and at most --concurrency jobs run at once.
+     */
+    std::atomic<size_t> nextJob{0};
+    auto serveJobs = [&]()
+    {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+        {
+            std::this_thread::sleep_until(arrivals[i]);
+            const TraceJob &job = jobs[i];
+            const Sample &sample = datasets.at(std::make_tuple(job.learner, job.n, job.p));
+            outcomes[i] = runJob(job, options, sample, learnerFor(job.learner), algoSeed + static_cast<unsigned int>(i));
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options.concurrency; ++w)
+        workers.emplace_back(serveJobs);
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // Latencies in milliseconds, in total and per class
+    std::vector<double> latenciesMs;
+    std::map<std::string, std::pair<std::vector<double>, size_t>> classes;
+    size_t numFailed = 0;
+    double serviceSeconds = 0.0;
+    auto lastFinish = start;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const JobOutcome &outcome = outcomes[i];
+        auto &jobClass = classes[jobs[i].learner + " " + jobs[i].method];
+        if (!outcome.ok)
+        {
+            ++numFailed;
+            ++jobClass.second;
+            std::cerr << "Job at line " << jobs[i].line << " (" << jobs[i].learner << " " << jobs[i].method << ", "
+                      << layoutName(jobs[i].storage) << ") failed: " << outcome.error << std::endl;
+            continue;
+        }
+        double latencyMs = std::chrono::duration<double, std::milli>(outcome.finish - arrivals[i]).count();
+        latenciesMs.push_back(latencyMs);
+        jobClass.first.push_back(latencyMs);
+        serviceSeconds += outcome.serviceSeconds;
+        lastFinish = std::max(lastFinish, outcome.finish);
+    }
+
+    double makespan = std::chrono::duration<double>(lastFinish - start).count();
+    size_t numCompleted = latenciesMs.size();
+    std::cout << "Completed " << numCompleted << " jobs (" << numFailed << " failed) in " << makespan << " seconds, "
+              << "throughput " << (makespan > 0 ? static_cast<double>(numCompleted) / makespan : 0.0) << " jobs/s, "
+              << "mean service time " << (numCompleted > 0 ? 1e3 * serviceSeconds / static_cast<double>(numCompleted) : 0.0)
+              << " ms" << std::endl;
+    std::cout << std::left << std::setw(18) << "class" << std::setw(8) << "jobs" << std::setw(8) << "failed"
+              << std::setw(12) << "p50 (ms)" << std::setw(12) << "p95 (ms)" << std::setw(12) << "p99 (ms)"
+              << std::setw(12) << "max (ms)" << std::endl;
+    for (const auto &[name, jobClass] : classes)
+        printLatencies(name, jobClass.first, jobClass.second);
+    printLatencies("all", latenciesMs, numFailed);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (argc % 2) != 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        runReplay(parseOptions(argc, argv));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "\n!!! An exception occurred during execution: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
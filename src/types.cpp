@@ -2,6 +2,10 @@
 
 #include <string>
 #include <iostream>
+#include <random>        // For std::mt19937, std::uniform_int_distribution
+#include <algorithm>     // For std::shuffle, std::min
+#include <stdexcept>     // For std::invalid_argument
+#include <unordered_map> // For the sparse Fisher-Yates shuffle
 #include <Eigen/Dense>
 
 // Helper function to print a Result
@@ -10,4 +14,57 @@ void printResult(const std::string &experimentName, const Result &result)
     // Use Eigen's built-in IO to format the output
     Eigen::IOFormat CommaInitFmt(Eigen::StreamPrecision, Eigen::DontAlignCols, ", ", ", ", "", "", "[", "]");
     std::cout << experimentName << " : " << result.transpose().format(CommaInitFmt) << std::endl;
-}
\ No newline at end of file
+}
+
+// Randomly permute the rows of sample in place
+void shuffleRows(Sample &sample, unsigned int seed)
+{
+    Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> permutation(sample.rows());
+    permutation.setIdentity();
+    std::mt19937 rng(seed);
+    std::shuffle(permutation.indices().data(), permutation.indices().data() + permutation.indices().size(), rng);
+    sample = permutation * sample;
+}
+
+// Helper function to draw k distinct positions in [0, n) as a union of random blocks
+std::vector<int> _sampleBlockPositions(int n, int k, int blockSize, std::mt19937 &rng)
+{
+    if (k < 0 || k > n || blockSize <= 0)
+        throw std::invalid_argument("_sampleBlockPositions: Requires 0 <= k <= n and blockSize > 0.");
+
+    int numBlocks = static_cast<int>((static_cast<long long>(n) + blockSize - 1) / blockSize);
+    std::vector<int> positions;
+    positions.reserve(k);
+    if (k == 0)
+        return positions;
+
+    /**
+     * The blocks are rotated by a random offset (modulo n), so that every position is drawn with probability k / n
+     * even though the last block may be shorter and only a prefix of the last drawn block is used.
+     */
+    int offset = std::uniform_int_distribution<int>(0, n - 1)(rng);
+
+    /**
+     * Partial Fisher-Yates shuffle of the block ids [0, numBlocks), where only the swapped entries are stored,
+     * so that the cost is proportional to the number of drawn blocks instead of numBlocks.
+     */
+    std::unordered_map<int, int> swapped;
+    auto blockAt = [&swapped](int i)
+    {
+        auto it = swapped.find(i);
+        return it == swapped.end() ? i : it->second;
+    };
+    for (int t = 0; static_cast<int>(positions.size()) < k; ++t)
+    {
+        int j = std::uniform_int_distribution<int>(t, numBlocks - 1)(rng);
+        int block = blockAt(j);
+        swapped[j] = blockAt(t);
+
+        long long start = static_cast<long long>(block) * blockSize;
+        int length = static_cast<int>(std::min<long long>(blockSize, n - start));
+        length = std::min(length, k - static_cast<int>(positions.size()));
+        for (int i = 0; i < length; ++i)
+            positions.push_back(static_cast<int>((start + i + offset) % n));
+    }
+    return positions;
+}